@@ -0,0 +1,330 @@
+// End to end input latency through the X server. A second connection injects key, button and
+// motion events with XTest at fixed rates and up to saturation, the window timestamps their
+// callbacks. Runs against $DISPLAY, which should be an Xvfb or Xephyr display so no real input
+// interferes, or starts its own Xvfb with --xvfb.
+//
+//     simple_window_latency_bench [--xvfb] [--display :99] [--duration ms]
+#include <simple_window/simple_window.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <xcb/xtest.h>
+
+#include "xvfb.hpp"
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    enum class input_kind { e_key, e_button, e_motion };
+    enum class dispatch_mode { e_poll, e_wait, e_batch, e_budget, e_reactor };
+
+    constexpr const char* kind_names[] = {"key", "button", "motion"};
+    constexpr const char* mode_names[] = {"poll_events", "wait_events", "poll_events(batch)",
+                                          "poll_events(budget)", "reactor"};
+
+    // Offered events per second, zero injects as fast as the connection takes them
+    constexpr double rates[] = {1000, 2000, 5000, 10000, 20000, 50000, 100000, 0};
+    constexpr std::size_t max_events = 50000;
+
+    class latency_window final : public sw::window_interface<latency_window> {
+        friend class sw::window_interface<latency_window>;
+
+    public:
+        latency_window() : window_interface<latency_window>("Latency bench", 640, 480) {}
+
+        void start(std::size_t expected) {
+            m_arrivals.clear();
+            m_arrivals.reserve(expected);
+        }
+
+        const std::vector<clock::time_point>& get_arrivals() const { return m_arrivals; }
+
+        void pump(const dispatch_mode mode) {
+            switch (mode) {
+                case dispatch_mode::e_poll: poll_events(); break;
+                case dispatch_mode::e_wait: wait_events(); break;
+                case dispatch_mode::e_batch: poll_events(m_batch, std::size(m_batch)); break;
+                case dispatch_mode::e_budget:
+                    poll_events(64, std::chrono::microseconds(500));
+                    break;
+                case dispatch_mode::e_reactor: {
+                    while (!prepare_read()) {
+                        dispatch_pending();
+                    }
+                    pollfd fd = {get_fd(), POLLIN, 0};
+                    ::poll(&fd, 1, 100);
+                    read_and_dispatch();
+                    break;
+                }
+            }
+        }
+
+    private:
+        void arrive() { m_arrivals.push_back(clock::now()); }
+
+        void on_key_down(sw::key_code) { arrive(); }
+        void on_key_up(sw::key_code) { arrive(); }
+        void on_mouse_button_down(sw::mouse_code, int, int) { arrive(); }
+        void on_mouse_button_up(sw::mouse_code, int, int) { arrive(); }
+        void on_mouse_move_pos(int, int) { arrive(); }
+
+    private:
+        std::vector<clock::time_point> m_arrivals;
+        sw::event m_batch[256];
+    };
+
+    // Own connection, XTest input is processed by the server exactly like device input
+    class injector {
+    public:
+        explicit injector(const xcb_window_t window) : m_connection(xcb_connect(nullptr, nullptr)) {
+            if (xcb_connection_has_error(m_connection) > 0) {
+                throw std::runtime_error("Failed to connect the injector");
+            }
+            m_root = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->root;
+
+            auto cookie = xcb_translate_coordinates(m_connection, window, m_root, 0, 0);
+            if (auto* reply = xcb_translate_coordinates_reply(m_connection, cookie, nullptr)) {
+                m_origin_x = reply->dst_x;
+                m_origin_y = reply->dst_y;
+                free(reply);
+            }
+
+            // Without a window manager keys go to the window under the pointer
+            xcb_test_fake_input(m_connection, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME, m_root,
+                                static_cast<int16_t>(m_origin_x + 320),
+                                static_cast<int16_t>(m_origin_y + 240), 0);
+            xcb_set_input_focus(m_connection, XCB_INPUT_FOCUS_POINTER_ROOT, window,
+                                XCB_CURRENT_TIME);
+            xcb_flush(m_connection);
+        }
+
+        ~injector() { xcb_disconnect(m_connection); }
+
+        // Presses alternate with releases. Keys cycle so a press never repeats the keycode of
+        // the release before it, which would be taken for auto repeat. Motion never stays on
+        // the same position, which would produce no event.
+        void send(const input_kind kind, const std::size_t index) {
+            const bool press = index % 2 == 0;
+            switch (kind) {
+                case input_kind::e_key: {
+                    const auto keycode = static_cast<uint8_t>(24 + (index / 2) % 10);
+                    xcb_test_fake_input(m_connection, press ? XCB_KEY_PRESS : XCB_KEY_RELEASE,
+                                        keycode, XCB_CURRENT_TIME, XCB_NONE, 0, 0, 0);
+                    break;
+                }
+                case input_kind::e_button: {
+                    xcb_test_fake_input(m_connection,
+                                        press ? XCB_BUTTON_PRESS : XCB_BUTTON_RELEASE, 1,
+                                        XCB_CURRENT_TIME, XCB_NONE, 0, 0, 0);
+                    break;
+                }
+                case input_kind::e_motion: {
+                    const auto x = static_cast<int16_t>(m_origin_x + 100 + index % 400);
+                    const auto y = static_cast<int16_t>(m_origin_y + 100 + index % 2);
+                    xcb_test_fake_input(m_connection, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME,
+                                        m_root, x, y, 0);
+                    break;
+                }
+            }
+            xcb_flush(m_connection);
+        }
+
+    private:
+        xcb_connection_t* m_connection;
+        xcb_window_t m_root;
+        int32_t m_origin_x = 0;
+        int32_t m_origin_y = 0;
+    };
+
+    struct run_result {
+        std::size_t sent = 0;
+        std::size_t received = 0;
+        double delivered_rate = 0.0;
+        double p50 = 0.0, p90 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;
+        bool backed_up = false;
+    };
+
+    double percentile(const std::vector<double>& sorted, const double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        const auto index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[index];
+    }
+
+    double median_of(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return percentile(values, 0.5);
+    }
+
+    void drain(latency_window& window) {
+        const auto until = clock::now() + std::chrono::milliseconds(50);
+        while (clock::now() < until) {
+            window.pump(dispatch_mode::e_poll);
+        }
+    }
+
+    run_result run(latency_window& window, injector& inject, const input_kind kind,
+                   const dispatch_mode mode, const double rate, const std::size_t count) {
+        using namespace std::chrono;
+
+        drain(window);
+        window.start(count);
+
+        std::vector<clock::time_point> injected(count);
+        std::atomic<bool> done = false;
+        const auto deadline =
+            clock::now() + seconds(2) +
+            (rate > 0 ? duration_cast<clock::duration>(duration<double>(count / rate))
+                      : clock::duration(0));
+
+        std::thread sender([&]() {
+            const auto period = rate > 0
+                                    ? duration_cast<clock::duration>(duration<double>(1 / rate))
+                                    : clock::duration(0);
+            auto next = clock::now();
+            for (std::size_t i = 0; i < count; ++i) {
+                if (rate > 0) {
+                    next += period;
+                    // Sleeping overshoots by tens of microseconds, the last stretch is spun
+                    std::this_thread::sleep_until(next - microseconds(200));
+                    while (clock::now() < next) {
+                    }
+                }
+                injected[i] = clock::now();
+                inject.send(kind, i);
+            }
+
+            // wait_events would block forever on lost events, a posted command wakes it
+            while (!done && clock::now() < deadline) {
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+            if (!done) {
+                window.post_set_name("Latency bench");
+            }
+        });
+
+        while (window.get_arrivals().size() < count && clock::now() < deadline &&
+               window.is_open()) {
+            window.pump(mode);
+        }
+        done = true;
+        sender.join();
+
+        const auto& arrivals = window.get_arrivals();
+        run_result result;
+        result.sent = count;
+        result.received = std::min(arrivals.size(), count);
+
+        // The server keeps the order, the n-th callback belongs to the n-th injected event
+        std::vector<double> latencies(result.received);
+        for (std::size_t i = 0; i < result.received; ++i) {
+            latencies[i] = duration<double, std::micro>(arrivals[i] - injected[i]).count();
+        }
+
+        if (result.received > 0) {
+            const auto span = arrivals[result.received - 1] - injected[0];
+            result.delivered_rate =
+                static_cast<double>(result.received) / duration<double>(span).count();
+
+            // Events back up when latency keeps growing over the run instead of staying flat
+            const auto tenth = std::max<std::size_t>(result.received / 10, 1);
+            const double first = median_of({latencies.begin(), latencies.begin() + tenth});
+            const double last = median_of({latencies.end() - tenth, latencies.end()});
+            result.backed_up = last > 2 * first + 50.0;
+        }
+        result.backed_up = result.backed_up || result.received < count;
+
+        std::sort(latencies.begin(), latencies.end());
+        result.p50 = percentile(latencies, 0.5);
+        result.p90 = percentile(latencies, 0.9);
+        result.p99 = percentile(latencies, 0.99);
+        result.p999 = percentile(latencies, 0.999);
+        result.max = latencies.empty() ? 0.0 : latencies.back();
+        return result;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    bool xvfb = false;
+    std::string display = ":99";
+    double duration_s = 0.5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--xvfb") == 0) {
+            xvfb = true;
+        }
+        else if (std::strcmp(argv[i], "--display") == 0 && i + 1 < argc) {
+            display = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration_s = std::atof(argv[++i]) / 1000.0;
+        }
+    }
+
+    pid_t server = 0;
+    int status = 0;
+    try {
+        if (xvfb) {
+            server = bench::spawn_xvfb(display);
+        }
+
+        latency_window window;
+        injector inject(window.get_window());
+
+        for (int k = 0; k < 3; ++k) {
+            for (int m = 0; m < 5; ++m) {
+                const auto kind = static_cast<input_kind>(k);
+                const auto mode = static_cast<dispatch_mode>(m);
+                std::printf("\n%s events, %s\n", kind_names[k], mode_names[m]);
+                std::printf("%10s %10s %10s %9s %9s %9s %9s %9s\n", "offered/s", "recv/s",
+                            "received", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+
+                double backs_up_at = -1.0;
+                for (const double rate : rates) {
+                    const auto count =
+                        rate > 0 ? std::clamp<std::size_t>(
+                                       static_cast<std::size_t>(rate * duration_s), 1000,
+                                       max_events)
+                                 : max_events;
+                    const auto r = run(window, inject, kind, mode, rate, count);
+
+                    char offered[16];
+                    rate > 0 ? std::snprintf(offered, sizeof(offered), "%.0f", rate)
+                             : std::snprintf(offered, sizeof(offered), "max");
+                    std::printf("%10s %10.0f %10zu %9.1f %9.1f %9.1f %9.1f %9.1f%s\n", offered,
+                                r.delivered_rate, r.received, r.p50, r.p90, r.p99, r.p999, r.max,
+                                r.backed_up ? "  backing up" : "");
+
+                    if (r.backed_up && backs_up_at < 0) {
+                        backs_up_at = rate > 0 ? rate : r.delivered_rate;
+                    }
+                }
+
+                if (backs_up_at > 0) {
+                    std::printf("backs up from %.0f events/s\n", backs_up_at);
+                }
+                else {
+                    std::printf("keeps up at every offered rate\n");
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        status = 1;
+    }
+
+    bench::stop_xvfb(server);
+    return status;
+}
\ No newline at end of file
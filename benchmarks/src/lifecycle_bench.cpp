@@ -0,0 +1,153 @@
+// Throughput of transient windows through the X server, every cycle creates a window, waits for
+// the first expose after mapping and destroys it again. Runs once constructing every window and
+// once recycling them through sw::window_pool. Runs against $DISPLAY, without a window manager
+// the numbers only contain the cost of the client and the server, or starts its own Xvfb.
+//
+//     simple_window_lifecycle_bench [--xvfb] [--display :99] [--cycles n]
+#include <simple_window/simple_window.hpp>
+#include <simple_window/window_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+
+#include "xvfb.hpp"
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    class lifecycle_window final : public sw::window_interface<lifecycle_window> {
+        friend class sw::window_interface<lifecycle_window>;
+
+    public:
+        lifecycle_window(const char* name, uint32_t width, uint32_t height)
+            : window_interface<lifecycle_window>(name, width, height) {}
+
+        // Dispatches until the first expose since creation or resume
+        void wait_for_expose() {
+            m_exposed = false;
+            poll_events();
+            while (!m_exposed) {
+                pollfd fd = {get_fd(), POLLIN, 0};
+                if (::poll(&fd, 1, 2000) == 0) {
+                    throw std::runtime_error("No expose event within 2 s");
+                }
+                poll_events();
+            }
+        }
+
+    private:
+        void on_expose(const sw::rect*, std::size_t) { m_exposed = true; }
+
+        bool m_exposed = false;
+    };
+
+    struct phase_times {
+        std::vector<double> create;
+        std::vector<double> expose;
+        std::vector<double> destroy;
+        double cycles_per_second = 0.0;
+    };
+
+    double micros(clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    double percentile(std::vector<double> samples, double p) {
+        std::sort(samples.begin(), samples.end());
+        return samples[static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1))];
+    }
+
+    // Create and Destroy are the halves of one cycle, either plain construction or the pool
+    template <typename Create, typename Destroy>
+    phase_times run(int cycles, Create&& create, Destroy&& destroy) {
+        phase_times times;
+        const auto start = clock::now();
+        for (int i = 0; i < cycles; ++i) {
+            const auto t0 = clock::now();
+            auto window = create(i);
+            const auto t1 = clock::now();
+            window->wait_for_expose();
+            const auto t2 = clock::now();
+            destroy(std::move(window));
+            const auto t3 = clock::now();
+
+            times.create.push_back(micros(t1 - t0));
+            times.expose.push_back(micros(t2 - t1));
+            times.destroy.push_back(micros(t3 - t2));
+        }
+        times.cycles_per_second =
+            cycles / std::chrono::duration<double>(clock::now() - start).count();
+        return times;
+    }
+
+    void print(const char* name, const phase_times& times) {
+        std::printf("\n%s: %.0f cycles/s\n", name, times.cycles_per_second);
+        std::printf("%-16s %9s %9s %9s\n", "phase", "p50 us", "p90 us", "p99 us");
+        const std::pair<const char*, const std::vector<double>*> phases[] = {
+            {"create", &times.create}, {"map to expose", &times.expose},
+            {"destroy", &times.destroy}};
+        for (const auto& [phase, samples] : phases) {
+            std::printf("%-16s %9.1f %9.1f %9.1f\n", phase, percentile(*samples, 0.5),
+                        percentile(*samples, 0.9), percentile(*samples, 0.99));
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    bool xvfb = false;
+    std::string display = ":99";
+    int cycles = 200;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--xvfb") == 0) {
+            xvfb = true;
+        }
+        else if (std::strcmp(argv[i], "--display") == 0 && i + 1 < argc) {
+            display = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    pid_t server = 0;
+    int status = 0;
+    try {
+        if (xvfb) {
+            server = bench::spawn_xvfb(display);
+        }
+
+        // Sizes change between cycles so a recycled window has to be reconfigured
+        const auto width = [](int i) { return 320u + static_cast<uint32_t>(i % 4) * 80; };
+        const auto height = [](int i) { return 200u + static_cast<uint32_t>(i % 3) * 60; };
+
+        auto construct = [&](int i) {
+            return std::make_unique<lifecycle_window>("Lifecycle bench", width(i), height(i));
+        };
+        auto destruct = [](std::unique_ptr<lifecycle_window> window) { window.reset(); };
+        print("new window per cycle", run(cycles, construct, destruct));
+
+        // The first cycle constructs, every later one resumes the same window
+        sw::window_pool<lifecycle_window> pool(1);
+        auto acquire = [&](int i) { return pool.acquire("Lifecycle bench", width(i), height(i)); };
+        auto release = [&](std::unique_ptr<lifecycle_window> window) {
+            pool.release(std::move(window));
+        };
+        print("window_pool", run(cycles, acquire, release));
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        status = 1;
+    }
+
+    bench::stop_xvfb(server);
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,373 @@
+// Dispatch microbenchmarks on detached windows fed with synthetic event streams, no X server
+// is needed. Prints nanoseconds per event, with --baseline <file> every result is compared
+// against a previous run and the exit code is 1 if one got slower than --tolerance percent.
+#include <simple_window/simple_window.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sched.h>
+
+namespace {
+    // Keeps the callbacks and translated results from being optimized away
+    volatile int64_t g_sink = 0;
+
+    constexpr std::size_t batch_size = 1024;
+    constexpr int repetitions = 100;
+    constexpr auto min_duration = std::chrono::milliseconds(10);
+
+    // No callbacks, measures the state tracking every event pays for
+    class bare_window final : public sw::window_interface<bare_window> {
+        friend class sw::window_interface<bare_window>;
+
+    public:
+        bare_window() : window_interface<bare_window>(sw::detached, 1280, 720) {}
+
+        void feed(const xcb_generic_event_t* events, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                inject_event(events[i]);
+            }
+            poll_events();
+        }
+
+        int64_t translate_keys(int rounds) const {
+            int64_t sum = 0;
+            for (int round = 0; round < rounds; ++round) {
+                for (int code = 0; code < 256; ++code) {
+                    sum += static_cast<int64_t>(keycode_to_enum(static_cast<uint8_t>(code)));
+                }
+            }
+            return sum;
+        }
+    };
+
+    // The usual per type callbacks, detected by has_on_*
+    class callback_window final : public sw::window_interface<callback_window> {
+        friend class sw::window_interface<callback_window>;
+
+    public:
+        callback_window() : window_interface<callback_window>(sw::detached, 1280, 720) {}
+
+        void feed(const xcb_generic_event_t* events, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                inject_event(events[i]);
+            }
+            poll_events();
+        }
+
+    private:
+        void on_key_down(sw::key_code key) { g_sink += static_cast<int>(key); }
+        void on_key_up(sw::key_code key) { g_sink -= static_cast<int>(key); }
+        void on_mouse_button_down(sw::mouse_code button, int x, int) {
+            g_sink += static_cast<int>(button) + x;
+        }
+        void on_mouse_button_up(sw::mouse_code button, int, int y) {
+            g_sink += static_cast<int>(button) + y;
+        }
+        void on_mouse_move_pos(int x, int y) { g_sink += x + y; }
+        void on_resize(uint32_t width, uint32_t height) { g_sink += width + height; }
+        void on_move(int x, int y) { g_sink += x - y; }
+        void on_expose(const sw::rect* rects, std::size_t count) { g_sink += rects[0].x + count; }
+        void on_focus_in() { ++g_sink; }
+        void on_focus_out() { --g_sink; }
+    };
+
+    // Everything through on_event, measures translating into sw::event
+    class event_window final : public sw::window_interface<event_window> {
+        friend class sw::window_interface<event_window>;
+
+    public:
+        event_window() : window_interface<event_window>(sw::detached, 1280, 720) {}
+
+        void feed(const xcb_generic_event_t* events, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                inject_event(events[i]);
+            }
+            poll_events();
+        }
+
+    private:
+        void on_event(const sw::event& e) { g_sink += static_cast<int>(e.type) + e.x; }
+    };
+
+    // Core events are at most 32 bytes on the wire, the rest is padding
+    template <typename Event>
+    xcb_generic_event_t to_generic(const Event& e) {
+        static_assert(sizeof(Event) <= 32);
+        xcb_generic_event_t generic = {};
+        std::memcpy(&generic, &e, sizeof(Event));
+        return generic;
+    }
+
+    // Keys typed in sequence, releases and presses carry different times so none of them is
+    // taken for auto repeat
+    std::vector<xcb_generic_event_t> key_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size / 2; ++i) {
+            xcb_key_press_event_t e = {};
+            e.detail = static_cast<uint8_t>(24 + i % 30);
+            e.event_x = 100;
+            e.event_y = 100;
+            e.time = 2 * i;
+            e.response_type = XCB_KEY_PRESS;
+            events.push_back(to_generic(e));
+            e.response_type = XCB_KEY_RELEASE;
+            e.time = 2 * i + 1;
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    std::vector<xcb_generic_event_t> button_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size / 2; ++i) {
+            xcb_button_press_event_t e = {};
+            e.detail = static_cast<uint8_t>(1 + i % 3);
+            e.event_x = static_cast<int16_t>(i % 1280);
+            e.event_y = static_cast<int16_t>(i % 720);
+            e.time = 2 * i;
+            e.response_type = XCB_BUTTON_PRESS;
+            events.push_back(to_generic(e));
+            e.response_type = XCB_BUTTON_RELEASE;
+            e.time = 2 * i + 1;
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    std::vector<xcb_generic_event_t> motion_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size; ++i) {
+            xcb_motion_notify_event_t e = {};
+            e.response_type = XCB_MOTION_NOTIFY;
+            e.event_x = static_cast<int16_t>(i % 1280);
+            e.event_y = static_cast<int16_t>((i * 3) % 720);
+            e.time = i;
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    // An interactive resize, coalesced into one on_resize per poll
+    std::vector<xcb_generic_event_t> configure_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size; ++i) {
+            xcb_configure_notify_event_t e = {};
+            e.response_type = XCB_CONFIGURE_NOTIFY | 0x80;
+            e.x = static_cast<int16_t>(i % 64);
+            e.y = 10;
+            e.width = static_cast<uint16_t>(640 + i % 640);
+            e.height = static_cast<uint16_t>(360 + i % 360);
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    // Sequences of four rects, the last one with count zero
+    std::vector<xcb_generic_event_t> expose_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size; ++i) {
+            xcb_expose_event_t e = {};
+            e.response_type = XCB_EXPOSE;
+            e.x = static_cast<uint16_t>((i % 4) * 200);
+            e.y = static_cast<uint16_t>((i % 4) * 100);
+            e.width = 150;
+            e.height = 80;
+            e.count = static_cast<uint16_t>(3 - i % 4);
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    std::vector<xcb_generic_event_t> focus_stream() {
+        std::vector<xcb_generic_event_t> events;
+        for (uint32_t i = 0; i < batch_size; ++i) {
+            xcb_focus_in_event_t e = {};
+            e.response_type = i % 2 == 0 ? XCB_FOCUS_IN : XCB_FOCUS_OUT;
+            events.push_back(to_generic(e));
+        }
+        return events;
+    }
+
+    // Roughly what a session of typing and pointing produces, mostly motion
+    std::vector<xcb_generic_event_t> mixed_stream() {
+        const auto keys = key_stream();
+        const auto buttons = button_stream();
+        const auto motion = motion_stream();
+
+        std::vector<xcb_generic_event_t> events;
+        for (std::size_t i = 0; events.size() < batch_size; ++i) {
+            events.push_back(motion[i % motion.size()]);
+            events.push_back(motion[(i + 1) % motion.size()]);
+            if (i % 4 == 0) {
+                events.push_back(keys[(i / 2) % keys.size()]);
+                events.push_back(keys[(i / 2 + 1) % keys.size()]);
+            }
+            if (i % 8 == 0) {
+                events.push_back(buttons[(i / 4) % buttons.size()]);
+                events.push_back(buttons[(i / 4 + 1) % buttons.size()]);
+            }
+        }
+        events.resize(batch_size);
+        return events;
+    }
+
+    // Time per operation of one repetition, which runs for at least min_duration
+    template <typename Run>
+    double measure_once(std::size_t operations_per_run, Run&& run) {
+        using namespace std::chrono;
+
+        std::size_t operations = 0;
+        const auto start = steady_clock::now();
+        auto now = start;
+        while (now - start < min_duration) {
+            run();
+            operations += operations_per_run;
+            now = steady_clock::now();
+        }
+        return duration<double, std::nano>(now - start).count() / static_cast<double>(operations);
+    }
+
+    // Fastest repetition, the minimum is the least disturbed by other load on the machine
+    template <typename Run>
+    double measure(std::size_t operations_per_run, Run&& run) {
+        run();
+        double best = std::numeric_limits<double>::max();
+        for (int r = 0; r < repetitions; ++r) {
+            best = std::min(best, measure_once(operations_per_run, run));
+        }
+        return best;
+    }
+
+    struct dispatch_result {
+        double bare = std::numeric_limits<double>::max();
+        double callbacks = std::numeric_limits<double>::max();
+        double on_event = std::numeric_limits<double>::max();
+    };
+
+    // The window types take turns within every repetition and the one going first rotates, so
+    // drift in clock speed or load affects all three alike and their results stay comparable
+    dispatch_result measure_dispatch(const std::vector<xcb_generic_event_t>& events) {
+        bare_window bare;
+        callback_window callbacks;
+        event_window on_event;
+        auto run_bare = [&]() { bare.feed(events.data(), events.size()); };
+        auto run_callbacks = [&]() { callbacks.feed(events.data(), events.size()); };
+        auto run_on_event = [&]() { on_event.feed(events.data(), events.size()); };
+        run_bare();
+        run_callbacks();
+        run_on_event();
+
+        dispatch_result result;
+        for (int r = 0; r < repetitions; ++r) {
+            for (int turn = 0; turn < 3; ++turn) {
+                switch ((r + turn) % 3) {
+                    case 0:
+                        result.bare = std::min(result.bare, measure_once(events.size(), run_bare));
+                        break;
+                    case 1:
+                        result.callbacks =
+                            std::min(result.callbacks, measure_once(events.size(), run_callbacks));
+                        break;
+                    default:
+                        result.on_event =
+                            std::min(result.on_event, measure_once(events.size(), run_on_event));
+                        break;
+                }
+            }
+        }
+        return result;
+    }
+
+    std::map<std::string, double> read_baseline(const char* path) {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string name;
+            double ns = 0.0;
+            if (fields >> name >> ns) {
+                baseline[name] = ns;
+            }
+        }
+        return baseline;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* baseline_path = nullptr;
+    double tolerance = 25.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--baseline") == 0) {
+            baseline_path = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0) {
+            tolerance = std::atof(argv[i + 1]);
+        }
+    }
+
+    // Migrating between cores in the middle of a repetition costs more than the events it
+    // measures, stay on the core the benchmark started on
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(sched_getcpu(), &cpus);
+    sched_setaffinity(0, sizeof(cpus), &cpus);
+
+    struct stream {
+        const char* name;
+        std::vector<xcb_generic_event_t> events;
+    };
+    const stream streams[] = {{"key", key_stream()},           {"button", button_stream()},
+                              {"motion", motion_stream()},     {"configure", configure_stream()},
+                              {"expose", expose_stream()},     {"focus", focus_stream()},
+                              {"mixed", mixed_stream()}};
+
+    std::vector<std::pair<std::string, double>> results;
+    for (const auto& s : streams) {
+        const std::string name = s.name;
+        const auto result = measure_dispatch(s.events);
+        results.emplace_back("dispatch/" + name + "/bare", result.bare);
+        results.emplace_back("dispatch/" + name + "/callbacks", result.callbacks);
+        results.emplace_back("dispatch/" + name + "/on_event", result.on_event);
+    }
+
+    {
+        bare_window window;
+        constexpr int rounds = 64;
+        results.emplace_back("keycode_to_enum", measure(rounds * 256, [&]() {
+                                 g_sink += window.translate_keys(rounds);
+                             }));
+    }
+
+    const auto baseline =
+        baseline_path != nullptr ? read_baseline(baseline_path) : std::map<std::string, double>();
+
+    int regressions = 0;
+    std::printf("# name ns/op Mop/s\n");
+    for (const auto& [name, ns] : results) {
+        std::printf("%-32s %10.2f %10.2f", name.c_str(), ns, 1000.0 / ns);
+        if (auto it = baseline.find(name); it != baseline.end() && it->second > 0.0) {
+            const double change = (ns - it->second) / it->second * 100.0;
+            const bool regressed = change > tolerance;
+            regressions += regressed ? 1 : 0;
+            std::printf(" %+8.1f%%%s", change, regressed ? " REGRESSION" : "");
+        }
+        std::printf("\n");
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
\ No newline at end of file
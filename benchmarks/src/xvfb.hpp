@@ -0,0 +1,44 @@
+#pragma once
+#include <simple_window/simple_window.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace bench {
+    // Starts Xvfb on the display and points $DISPLAY at it, returns its pid
+    inline pid_t spawn_xvfb(const std::string& display) {
+        const char* argv[] = {"Xvfb", display.c_str(), "-screen", "0", "1280x720x24",
+                              "-nolisten", "tcp", nullptr};
+        pid_t pid = 0;
+        if (posix_spawnp(&pid, "Xvfb", nullptr, nullptr, const_cast<char**>(argv), environ) != 0) {
+            throw std::runtime_error("Failed to start Xvfb");
+        }
+        setenv("DISPLAY", display.c_str(), 1);
+
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            if (sw::detail::window_xcb::is_display_available()) {
+                return pid;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        throw std::runtime_error("Xvfb did not come up");
+    }
+
+    inline void stop_xvfb(const pid_t pid) {
+        if (pid != 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+} // namespace bench
\ No newline at end of file
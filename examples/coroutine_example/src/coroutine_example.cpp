@@ -0,0 +1,48 @@
+#include <simple_window/coroutine.hpp>
+
+#include <iostream>
+
+class window final : public sw::coroutine_window<window> {
+    friend class sw::window_interface<window>;
+
+public:
+    window() : coroutine_window<window>("Coroutine example", 960, 540) {}
+};
+
+sw::task rename_flow(window& w) {
+    for (;;) {
+        co_await w.key_pressed(sw::key_code::e_enter);
+        std::cout << "Click to confirm rename, escape to cancel\n";
+
+        for (;;) {
+            const auto e = co_await w.next_event();
+            if (e.type == sw::event_type::e_mouse_button_down) {
+                w.set_name("Renamed window");
+                std::cout << "Renamed at " << e.x << ", " << e.y << '\n';
+                break;
+            }
+            if (e.type == sw::event_type::e_key_down && e.key == sw::key_code::e_escape) {
+                std::cout << "Cancelled\n";
+                break;
+            }
+        }
+    }
+}
+
+sw::task resize_logger(window& w) {
+    for (;;) {
+        const auto e = co_await w.next_event(sw::event_type::e_resize);
+        std::cout << "Window resize: " << e.x << ", " << e.y << '\n';
+    }
+}
+
+int main() {
+    window window;
+
+    rename_flow(window);
+    resize_logger(window);
+
+    sw::event_loop loop;
+    loop.add(window);
+    loop.run();
+}
\ No newline at end of file
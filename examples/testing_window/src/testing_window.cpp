@@ -1,36 +1,66 @@
 #include <simple_window/simple_window.hpp>
 
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 class window final : public sw::window_interface<window> {
     friend class sw::window_interface<window>;
 
+    enum action : sw::action_id {
+        e_cursor_1,
+        e_cursor_9 = e_cursor_1 + 8,
+        e_lock,
+        e_unlock,
+        e_fullscreen
+    };
+
 public:
-    window() : window_interface<window>("Testing window", 960, 540) {}
+    window() : window_interface<window>("Testing window", 960, 540) { bind_actions(); }
 
     void update() { poll_events(); }
 
+#if defined(__linux__) && !defined(SW_NULL_BACKEND)
+    explicit window(sw::detached_t) : window_interface<window>(sw::detached, 960, 540) {
+        bind_actions();
+    }
+
+    void record(sw::input_recorder* recorder) { record_input(recorder); }
+    bool replay(sw::input_replayer& replayer) { return replay_events(replayer); }
+#endif
+
 protected:
-    void on_key_down(const sw::key_code code) {
-        switch (code) {
-            case sw::key_code::e_1: set_cursor_image(sw::cursor_icon::e_arrow); break;
-            case sw::key_code::e_2: set_cursor_image(sw::cursor_icon::e_hand); break;
-            case sw::key_code::e_3: set_cursor_image(sw::cursor_icon::e_text); break;
-            case sw::key_code::e_4: set_cursor_image(sw::cursor_icon::e_resize_all); break;
-            case sw::key_code::e_5: set_cursor_image(sw::cursor_icon::e_resize_EW); break;
-            case sw::key_code::e_6: set_cursor_image(sw::cursor_icon::e_resize_NS); break;
-            case sw::key_code::e_7: set_cursor_image(sw::cursor_icon::e_resize_NESW); break;
-            case sw::key_code::e_8: set_cursor_image(sw::cursor_icon::e_resize_NWSE); break;
-            case sw::key_code::e_9: set_cursor_image(sw::cursor_icon::e_loading); break;
-            case sw::key_code::e_space:
+    void on_action(const sw::action_id action, const sw::action_phase phase) {
+        if (phase != sw::action_phase::e_pressed) {
+            return;
+        }
+
+        static constexpr sw::cursor_icon cursors[] = {
+            sw::cursor_icon::e_arrow,       sw::cursor_icon::e_hand,
+            sw::cursor_icon::e_text,        sw::cursor_icon::e_resize_all,
+            sw::cursor_icon::e_resize_EW,   sw::cursor_icon::e_resize_NS,
+            sw::cursor_icon::e_resize_NESW, sw::cursor_icon::e_resize_NWSE,
+            sw::cursor_icon::e_loading};
+
+        switch (action) {
+            case e_lock:
                 lock_cursor();
                 // hide_cursor();
                 break;
-            case sw::key_code::e_U:
+            case e_unlock:
                 unlock_cursor();
                 // show_cursor();
                 break;
-            default: break;
+            case e_fullscreen:
+                m_fullscreen = !m_fullscreen;
+                set_fullscreen(m_fullscreen);
+                break;
+            default:
+                if (action <= e_cursor_9) {
+                    set_cursor_image(cursors[action - e_cursor_1]);
+                }
+                break;
         }
     }
 
@@ -52,11 +82,50 @@ protected:
     void on_close() { std::cout << "Close\n"; }
 
     void on_focus(bool focus) { std::cout << "Focus: " << focus << '\n'; }
+
+private:
+    void bind_actions() {
+        for (sw::action_id i = 0; i < 9; ++i) {
+            const auto key = static_cast<sw::key_code>(static_cast<int>(sw::key_code::e_1) + i);
+            m_actions.bind(e_cursor_1 + i, {key});
+        }
+        m_actions.bind(e_lock, {sw::key_code::e_space});
+        m_actions.bind(e_unlock, {sw::key_code::e_U});
+        m_actions.bind(e_fullscreen, {sw::key_code::e_F}, sw::modifier::e_ctrl);
+        set_action_map(&m_actions);
+    }
+
+    sw::action_map m_actions;
+    bool m_fullscreen = false;
 };
 
-int main() {
+int main(int argc, char** argv) {
+#if defined(__linux__) && !defined(SW_NULL_BACKEND)
+    // testing_window record <log> captures the session, testing_window replay <log> plays it
+    // back into a detached window so no display is needed
+    if (argc == 3 && std::strcmp(argv[1], "replay") == 0) {
+        window replayed(sw::detached);
+        sw::input_replayer replayer(argv[2]);
+        while (replayed.is_open() && replayed.replay(replayer)) {
+            std::this_thread::sleep_until(replayer.get_next_time());
+        }
+        return 0;
+    }
+#endif
+
     window window;
 
+#if defined(__linux__) && !defined(SW_NULL_BACKEND)
+    std::unique_ptr<sw::input_recorder> recorder;
+    if (argc == 3 && std::strcmp(argv[1], "record") == 0) {
+        recorder = std::make_unique<sw::input_recorder>(argv[2]);
+        window.record(recorder.get());
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+
     while (window.is_open()) {
         window.update();
     }
@@ -10,7 +10,9 @@
 #include <set>
 
 #include <vulkan/vulkan.hpp>
-#if defined(__linux__)
+#if defined(SW_NULL_BACKEND)
+// VK_EXT_headless_surface is part of vulkan_core.h
+#elif defined(__linux__)
 #    include <vulkan/vulkan_xcb.h>
 #elif defined(_WIN32)
 #    include <vulkan/vulkan_win32.h>
@@ -173,6 +175,10 @@ private:
     std::vector<vk::Fence> m_in_flight;
     size_t m_current_frame = 0;
 
+    // Frames in which late latching saw pointer motion newer than the poll at frame start
+    size_t m_latched_frames = 0;
+    size_t m_frame_count = 0;
+
 private:
     void destroy_window_dependet_resources() {
         m_device.waitForFences(m_in_flight, VK_TRUE, std::numeric_limits<uint64_t>::max());
@@ -224,7 +230,9 @@ private:
         extensions.reserve(debug_mode ? 3 : 2);
         extensions.emplace_back(VK_KHR_SURFACE_EXTENSION_NAME);
 
-#if defined(__linux__)
+#if defined(SW_NULL_BACKEND)
+        extensions.emplace_back(window::vulkan_surface_extension);
+#elif defined(__linux__)
         extensions.emplace_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 #elif defined(_WIN32)
         extensions.emplace_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
@@ -247,7 +255,18 @@ private:
 
     void create_surface() {
         VkSurfaceKHR surface;
-#if defined(__linux__)
+#if defined(SW_NULL_BACKEND)
+        // Not exported by the loader, extension commands are looked up on the instance
+        auto create_headless_surface = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+            vkGetInstanceProcAddr(m_instance, "vkCreateHeadlessSurfaceEXT"));
+        VkHeadlessSurfaceCreateInfoEXT surfaceCreateInfo = {};
+        surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+        if (create_headless_surface == nullptr ||
+            create_headless_surface(m_instance, &surfaceCreateInfo, nullptr, &surface) !=
+                VK_SUCCESS) {
+            throw std::runtime_error("Failed to create surface");
+        }
+#elif defined(__linux__)
         VkXcbSurfaceCreateInfoKHR surfaceCreateInfo = {};
         surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
         surfaceCreateInfo.connection = m_window.get_connection();
@@ -582,6 +601,20 @@ private:
             return;
         }
 
+#if defined(__linux__)
+        // Waiting for the fence and the image takes most of a frame, input that arrived in the
+        // meantime would be written into this frame's uniforms right here
+        m_window.latch_input();
+        if (m_window.get_latched_mouse_x() != m_window.get_mouse_x() ||
+            m_window.get_latched_mouse_y() != m_window.get_mouse_y()) {
+            ++m_latched_frames;
+        }
+        if (++m_frame_count % 1000 == 0) {
+            std::cout << "Late latched pointer motion in " << m_latched_frames << " of "
+                      << m_frame_count << " frames\n";
+        }
+#endif
+
         vk::PipelineStageFlags wait_stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
         vk::SubmitInfo submit_info = {1,
                                       &m_image_available[m_current_frame],
@@ -604,6 +637,12 @@ private:
             present_result == vk::Result::eSuboptimalKHR || m_window.should_resize()) {
             recreate_window_dependent_resources();
         }
+#if defined(__linux__)
+        // The frame just presented already has the size the window manager asked for
+        else if (m_window.is_sync_request_pending()) {
+            m_window.ack_sync_request();
+        }
+#endif
 
         m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
     }
@@ -1,6 +1,15 @@
 #include "window.hpp"
 
-window::window() : window_interface<window>("Vulkan example", 960, 540), m_should_resize(false) {}
+window::window() : window_interface<window>("Vulkan example", 960, 540), m_should_resize(false) {
+#if defined(__linux__)
+    // Avoids degenerate swapchains and limits the number of distinct swapchain sizes
+    set_min_size(64, 64);
+    set_resize_increment(8, 8);
+
+    // Stop rendering while minimized or covered
+    set_block_while_hidden(true);
+#endif
+}
 
 bool window::should_resize() {
     bool tmp = m_should_resize;
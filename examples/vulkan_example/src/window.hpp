@@ -14,6 +14,8 @@ public:
 private:
     void on_key_down(sw::key_code code);
     void on_resize(uint32_t width, uint32_t height);
+    // Opts in to compositor synchronized resizing, acknowledged after presenting
+    void on_sync_request() {}
 
 private:
     bool m_should_resize;
@@ -0,0 +1,254 @@
+#pragma once
+#include "simple_window/enums.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace sw {
+    using action_id = uint16_t;
+
+    // Modifiers match either the left or the right key
+    enum class modifier : std::uint8_t {
+        e_none = 0,
+        e_shift = 1,
+        e_ctrl = 2,
+        e_alt = 4,
+        e_super = 8
+    };
+
+    constexpr modifier operator|(const modifier a, const modifier b) {
+        return static_cast<modifier>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+    }
+
+    // Keys and mouse buttons share one index space in the binding tables
+    struct action_input {
+        static constexpr uint8_t key_count = static_cast<uint8_t>(key_code::e_MAX_KEYS);
+        static constexpr uint8_t count =
+            key_count + static_cast<uint8_t>(mouse_code::e_MAX_BUTTONS);
+
+        // e_NONE and anything past the last key or button map to count, which every lookup
+        // ignores
+        constexpr action_input(const key_code key)
+            : index(key < key_code::e_MAX_KEYS ? static_cast<uint8_t>(key) : count) {}
+        constexpr action_input(const mouse_code button)
+            : index(button < mouse_code::e_MAX_BUTTONS
+                        ? static_cast<uint8_t>(key_count + static_cast<uint8_t>(button))
+                        : count) {}
+
+        uint8_t index;
+    };
+
+    static_assert(action_input(key_code::e_NONE).index == action_input::count &&
+                      action_input(mouse_code::e_NONE).index == action_input::count,
+                  "e_NONE must not alias a bindable input");
+
+    // Maps keys, mouse buttons and chords of them to application actions. Bindings are compiled
+    // into flat per input tables, so feeding input is a table lookup and never allocates. Binding
+    // and unbinding rebuild the tables, bindings that are active stay active across it.
+    class action_map {
+    public:
+        static constexpr std::size_t max_chord = 4;
+
+        // Up to max_chord inputs held together, the action starts when the last of them goes
+        // down in any order while the modifiers are held. It ends when any of them is released.
+        void bind(const action_id action, std::initializer_list<action_input> chord,
+                  const modifier modifiers = modifier::e_none) {
+            binding b = {};
+            b.action = action;
+            b.modifiers = static_cast<uint8_t>(modifiers);
+            for (const auto input : chord) {
+                if (b.input_count < max_chord && input.index < action_input::count) {
+                    b.inputs[b.input_count++] = input.index;
+                }
+            }
+
+            if (b.input_count > 0) {
+                m_bindings.push_back(b);
+                m_active.push_back(false);
+                rebuild();
+            }
+        }
+
+        // Removed bindings that are active end through on_action, the others stay active
+        template <typename OnAction>
+        void unbind(const action_id action, OnAction&& on_action) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < m_bindings.size(); ++i) {
+                if (m_bindings[i].action != action) {
+                    m_bindings[kept] = m_bindings[i];
+                    m_active[kept] = m_active[i];
+                    ++kept;
+                }
+                else if (m_active[i]) {
+                    on_action(action, action_phase::e_released);
+                }
+            }
+            m_bindings.resize(kept);
+            m_active.resize(kept);
+            rebuild();
+        }
+
+        template <typename OnAction>
+        void clear(OnAction&& on_action) {
+            for (std::size_t i = 0; i < m_bindings.size(); ++i) {
+                if (m_active[i]) {
+                    on_action(m_bindings[i].action, action_phase::e_released);
+                }
+            }
+            m_bindings.clear();
+            m_active.clear();
+            rebuild();
+        }
+
+        // OnAction is called as on_action(action_id, action_phase) for every action that
+        // starts or ends
+        template <typename OnAction>
+        void press(const action_input input, OnAction&& on_action) {
+            if (input.index >= action_input::count || m_held[input.index]) {
+                return;
+            }
+            m_held.set(input.index);
+
+            const auto modifiers = held_modifiers();
+
+            // Entries are sorted by specificity, only the most specific matches fire so
+            // ctrl + S does not also trigger S
+            uint8_t matched_specificity = 0;
+            for (auto i = m_offsets[input.index]; i < m_offsets[input.index + 1]; ++i) {
+                const auto& e = m_entries[i];
+                if (e.specificity < matched_specificity) {
+                    break;
+                }
+                if ((m_held & e.held) != e.held || (modifiers & e.modifiers) != e.modifiers ||
+                    m_active[e.binding]) {
+                    continue;
+                }
+
+                matched_specificity = e.specificity;
+                m_active[e.binding] = true;
+                on_action(m_bindings[e.binding].action, action_phase::e_pressed);
+            }
+        }
+
+        template <typename OnAction>
+        void release(const action_input input, OnAction&& on_action) {
+            if (input.index >= action_input::count || !m_held[input.index]) {
+                return;
+            }
+            m_held.reset(input.index);
+
+            for (auto i = m_offsets[input.index]; i < m_offsets[input.index + 1]; ++i) {
+                const auto binding = m_entries[i].binding;
+                if (m_active[binding]) {
+                    m_active[binding] = false;
+                    on_action(m_bindings[binding].action, action_phase::e_released);
+                }
+            }
+        }
+
+        // Ends every active action, used when the window loses focus
+        template <typename OnAction>
+        void release_all(OnAction&& on_action) {
+            m_held.reset();
+            for (std::size_t i = 0; i < m_bindings.size(); ++i) {
+                if (m_active[i]) {
+                    m_active[i] = false;
+                    on_action(m_bindings[i].action, action_phase::e_released);
+                }
+            }
+        }
+
+    private:
+        using input_set = std::bitset<action_input::count>;
+
+        struct binding {
+            action_id action;
+            uint8_t modifiers;
+            uint8_t input_count;
+            uint8_t inputs[max_chord];
+        };
+
+        // One entry per input of every binding, holding what else has to be down
+        struct entry {
+            input_set held;
+            uint16_t binding;
+            uint8_t modifiers;
+            uint8_t specificity;
+        };
+
+        uint8_t held_modifiers() const {
+            auto held = [this](const key_code left, const key_code right) {
+                return m_held[static_cast<uint8_t>(left)] || m_held[static_cast<uint8_t>(right)];
+            };
+
+            uint8_t modifiers = 0;
+            modifiers |= held(key_code::e_left_shift, key_code::e_right_shift) ? 1 : 0;
+            modifiers |= held(key_code::e_left_ctrl, key_code::e_right_ctrl) ? 2 : 0;
+            modifiers |= held(key_code::e_left_alt, key_code::e_right_alt) ? 4 : 0;
+            modifiers |= held(key_code::e_left_super, key_code::e_right_super) ? 8 : 0;
+            return modifiers;
+        }
+
+        void rebuild() {
+            m_entries.clear();
+            for (std::size_t b = 0; b < m_bindings.size(); ++b) {
+                const auto& bound = m_bindings[b];
+                const auto specificity = static_cast<uint8_t>(
+                    bound.input_count + std::bitset<8>(bound.modifiers).count());
+
+                for (uint8_t trigger = 0; trigger < bound.input_count; ++trigger) {
+                    entry e = {};
+                    e.binding = static_cast<uint16_t>(b);
+                    e.modifiers = bound.modifiers;
+                    e.specificity = specificity;
+                    for (uint8_t i = 0; i < bound.input_count; ++i) {
+                        if (i != trigger) {
+                            e.held.set(bound.inputs[i]);
+                        }
+                    }
+                    m_entry_inputs.push_back(bound.inputs[trigger]);
+                    m_entries.push_back(e);
+                }
+            }
+
+            // Group the entries by input, most specific first, and index the groups
+            std::vector<std::size_t> order(m_entries.size());
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+                if (m_entry_inputs[a] != m_entry_inputs[b]) {
+                    return m_entry_inputs[a] < m_entry_inputs[b];
+                }
+                return m_entries[a].specificity > m_entries[b].specificity;
+            });
+
+            std::vector<entry> sorted;
+            sorted.reserve(m_entries.size());
+            std::fill(std::begin(m_offsets), std::end(m_offsets), uint16_t(0));
+            for (const auto i : order) {
+                sorted.push_back(m_entries[i]);
+                ++m_offsets[m_entry_inputs[i] + 1];
+            }
+            for (std::size_t i = 1; i <= action_input::count; ++i) {
+                m_offsets[i] += m_offsets[i - 1];
+            }
+
+            m_entries = std::move(sorted);
+            m_entry_inputs.clear();
+        }
+
+    private:
+        std::vector<binding> m_bindings;
+        std::vector<entry> m_entries;
+        std::vector<uint8_t> m_entry_inputs;
+        uint16_t m_offsets[action_input::count + 1] = {};
+        std::vector<bool> m_active;
+        input_set m_held;
+    };
+} // namespace sw
\ No newline at end of file
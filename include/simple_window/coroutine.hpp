@@ -0,0 +1,332 @@
+#pragma once
+#include "simple_window/simple_window.hpp"
+#include "simple_window/event.hpp"
+
+#if !defined(__cpp_impl_coroutine)
+#    error "simple_window: coroutine.hpp requires C++20 coroutine support"
+#endif
+
+#if !defined(__linux__) || defined(SW_NULL_BACKEND)
+#    error "simple_window: coroutine.hpp is only supported by the xcb backend"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <vector>
+
+#include <poll.h>
+
+namespace sw {
+    namespace detail {
+        // Recycles the coroutine frames of the tasks started on one window, so starting a task
+        // does not hit the heap once the pool is warm. Every frame records the pool it came from
+        // and goes back there, the pool lives until its window and all its frames are gone.
+        // Frames larger than block_size and frames of tasks without a window use the global
+        // allocator.
+        class frame_pool {
+        public:
+            static constexpr std::size_t block_size = 1024;
+
+            static void* allocate(frame_pool* pool, std::size_t size) {
+                frame_header* header = nullptr;
+                if (pool == nullptr || size > block_size) {
+                    header = static_cast<frame_header*>(::operator new(header_size + size));
+                    header->pool = nullptr;
+                }
+                else {
+                    if (pool->m_head != nullptr) {
+                        header = reinterpret_cast<frame_header*>(pool->m_head);
+                        pool->m_head = pool->m_head->next;
+                    }
+                    else {
+                        header = static_cast<frame_header*>(::operator new(header_size + block_size));
+                    }
+                    header->pool = pool;
+                    ++pool->m_references;
+                }
+                return reinterpret_cast<unsigned char*>(header) + header_size;
+            }
+
+            static void deallocate(void* ptr) {
+                auto* header = reinterpret_cast<frame_header*>(static_cast<unsigned char*>(ptr) -
+                                                               header_size);
+                auto* pool = header->pool;
+                if (pool == nullptr) {
+                    ::operator delete(header);
+                    return;
+                }
+
+                auto* block = reinterpret_cast<free_block*>(header);
+                block->next = pool->m_head;
+                pool->m_head = block;
+                pool->release();
+            }
+
+            // Drops one reference, the owning window holds the first one
+            void release() {
+                if (--m_references == 0) {
+                    delete this;
+                }
+            }
+
+        private:
+            struct frame_header {
+                frame_pool* pool;
+            };
+            struct free_block {
+                free_block* next;
+            };
+
+            // Keeps the frame behind the header aligned like a plain operator new allocation
+            static constexpr std::size_t header_size = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+            ~frame_pool() {
+                while (m_head != nullptr) {
+                    auto* next = m_head->next;
+                    ::operator delete(m_head);
+                    m_head = next;
+                }
+            }
+
+        private:
+            free_block* m_head = nullptr;
+            std::size_t m_references = 1;
+        };
+
+        // Intrusive node living inside the awaiting coroutine frame, so awaiting never allocates
+        struct event_waiter {
+            event_waiter* next = nullptr;
+            std::coroutine_handle<> handle;
+
+            event_type type = event_type::e_NONE;
+            key_code key = key_code::e_NONE;
+            event result;
+
+            bool matches(const event& e) const {
+                return (type == event_type::e_NONE || type == e.type) &&
+                       (key == key_code::e_NONE || key == e.key);
+            }
+        };
+    } // namespace detail
+
+    template <typename Window>
+    class coroutine_window;
+
+    // Fire-and-forget coroutine started eagerly and destroyed when it runs to completion.
+    // Tasks still suspended on a window are destroyed together with that window. A task whose
+    // first parameter is a coroutine_window takes its frame from that window's pool and must
+    // be started on the thread dispatching the window.
+    class task {
+    public:
+        struct promise_type {
+            task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+
+            template <typename Window, typename... Args>
+            static void* operator new(std::size_t size, coroutine_window<Window>& owner,
+                                      Args&...) {
+                return detail::frame_pool::allocate(owner.m_frames, size);
+            }
+            static void* operator new(std::size_t size) {
+                return detail::frame_pool::allocate(nullptr, size);
+            }
+            static void operator delete(void* ptr) { detail::frame_pool::deallocate(ptr); }
+        };
+    };
+
+    class event_loop;
+
+    template <typename Window>
+    class coroutine_window : public window_interface<Window> {
+        friend class window_interface<Window>;
+        friend class event_loop;
+        friend struct task::promise_type;
+
+        class event_awaiter {
+        public:
+            event_awaiter(coroutine_window& window, event_type type, key_code key)
+                : m_window(window) {
+                m_waiter.type = type;
+                m_waiter.key = key;
+            }
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                m_waiter.handle = handle;
+                m_window.push_waiter(&m_waiter);
+            }
+
+            event await_resume() const noexcept { return m_waiter.result; }
+
+        private:
+            coroutine_window& m_window;
+            detail::event_waiter m_waiter;
+        };
+
+    protected:
+        coroutine_window(const char* name, uint32_t width, uint32_t height)
+            : window_interface<Window>(name, width, height) {}
+
+        ~coroutine_window() {
+            auto* waiter = m_waiters_head;
+            while (waiter != nullptr) {
+                auto* next = waiter->next;
+                waiter->handle.destroy();
+                waiter = next;
+            }
+            m_frames->release();
+        }
+
+    public:
+        // Resumes with the next event of the given type, or any event if type is e_NONE
+        event_awaiter next_event(event_type type = event_type::e_NONE) {
+            return event_awaiter(*this, type, key_code::e_NONE);
+        }
+
+        event_awaiter key_pressed(key_code key) {
+            return event_awaiter(*this, event_type::e_key_down, key);
+        }
+
+        event_awaiter key_released(key_code key) {
+            return event_awaiter(*this, event_type::e_key_up, key);
+        }
+
+    private:
+        // Called by the window interface for every event after on_event, resumes every task
+        // waiting for a matching event
+        void resume_waiters(const event& e) {
+            auto* waiter = m_waiters_head;
+            m_waiters_head = m_waiters_tail = nullptr;
+
+            // Tasks resumed below may await again, those waiters land in the fresh list and
+            // will not see the current event
+            detail::event_waiter* kept_head = nullptr;
+            detail::event_waiter* kept_tail = nullptr;
+            while (waiter != nullptr) {
+                auto* next = waiter->next;
+                if (waiter->matches(e)) {
+                    waiter->result = e;
+                    waiter->handle.resume();
+                }
+                else {
+                    waiter->next = nullptr;
+                    kept_tail != nullptr ? (kept_tail->next = waiter) : (kept_head = waiter);
+                    kept_tail = waiter;
+                }
+                waiter = next;
+            }
+
+            if (kept_tail != nullptr) {
+                kept_tail->next = m_waiters_head;
+                if (m_waiters_head == nullptr) {
+                    m_waiters_tail = kept_tail;
+                }
+                m_waiters_head = kept_head;
+            }
+        }
+
+        void push_waiter(detail::event_waiter* waiter) {
+            waiter->next = nullptr;
+            m_waiters_tail != nullptr ? (m_waiters_tail->next = waiter) : (m_waiters_head = waiter);
+            m_waiters_tail = waiter;
+        }
+
+    private:
+        detail::event_waiter* m_waiters_head = nullptr;
+        detail::event_waiter* m_waiters_tail = nullptr;
+        detail::frame_pool* m_frames = new detail::frame_pool();
+    };
+
+    // Waits on the connection file descriptors of all added windows and dispatches their events,
+    // which resumes the tasks awaiting them
+    class event_loop {
+    public:
+        template <typename Window>
+        void add(coroutine_window<Window>& window) {
+            m_sources.push_back(
+                {&window, window.get_fd(), &prepare<Window>, &read<Window>, &is_open<Window>});
+            m_fds.push_back({});
+        }
+
+        // Returns false when no added window is open anymore
+        bool run_once(int timeout_ms = -1) {
+            // Events already read from the socket would not be reported by poll
+            for (auto& source : m_sources) {
+                const int source_timeout = source.prepare(source.window);
+                if (source_timeout >= 0 && (timeout_ms < 0 || source_timeout < timeout_ms)) {
+                    timeout_ms = source_timeout;
+                }
+            }
+
+            if (!any_open()) {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < m_sources.size(); ++i) {
+                m_fds[i] = {m_sources[i].fd, POLLIN, 0};
+            }
+
+            if (::poll(m_fds.data(), m_fds.size(), timeout_ms) > 0) {
+                for (std::size_t i = 0; i < m_sources.size(); ++i) {
+                    if (m_fds[i].revents != 0) {
+                        m_sources[i].read(m_sources[i].window);
+                    }
+                }
+            }
+            return any_open();
+        }
+
+        void run() {
+            while (run_once()) {
+            }
+        }
+
+    private:
+        struct source {
+            void* window;
+            int fd;
+            int (*prepare)(void*);
+            void (*read)(void*);
+            bool (*is_open)(const void*);
+        };
+
+        // Returns how long the window can wait before deferred notifications are due
+        template <typename Window>
+        static int prepare(void* window) {
+            auto* w = static_cast<coroutine_window<Window>*>(window);
+            do {
+                w->dispatch_pending();
+            } while (!w->prepare_read());
+            return w->get_dispatch_timeout();
+        }
+
+        template <typename Window>
+        static void read(void* window) {
+            static_cast<coroutine_window<Window>*>(window)->read_and_dispatch();
+        }
+
+        template <typename Window>
+        static bool is_open(const void* window) {
+            return static_cast<const coroutine_window<Window>*>(window)->is_open();
+        }
+
+        bool any_open() const {
+            for (const auto& source : m_sources) {
+                if (source.is_open(source.window)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        std::vector<source> m_sources;
+        std::vector<pollfd> m_fds;
+    };
+} // namespace sw
\ No newline at end of file
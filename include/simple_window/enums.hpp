@@ -14,6 +14,21 @@ namespace sw {
         e_loading
     };
 
+    enum class window_visual : std::uint8_t {
+        // Depth 24 TrueColor, presented without alpha blending by compositors
+        e_opaque,
+        // Depth 32 ARGB for translucent overlays
+        e_transparent
+    };
+
+    enum class clipboard_selection : std::uint8_t { e_clipboard, e_primary };
+
+    enum class pointer_predictor : std::uint8_t { e_linear, e_filtered };
+
+    enum class action_phase : std::uint8_t { e_pressed, e_released };
+
+    enum class backend : std::uint8_t { e_native, e_null };
+
     enum class key_code : std::uint8_t {
         e_0,
         e_1,
@@ -134,4 +149,20 @@ namespace sw {
         e_MAX_BUTTONS,
         e_NONE
     };
+
+    enum class event_type : std::uint8_t {
+        e_close,
+        e_resize,
+        e_resize_end,
+        e_focus_in,
+        e_focus_out,
+        e_key_down,
+        e_key_up,
+        e_mouse_button_down,
+        e_mouse_button_up,
+        e_mouse_scroll_v,
+        e_mouse_scroll_h,
+        e_mouse_move,
+        e_NONE
+    };
 } // namespace sw
\ No newline at end of file
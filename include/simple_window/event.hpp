@@ -0,0 +1,40 @@
+#pragma once
+#include "simple_window/enums.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace sw {
+    struct rect {
+        int32_t x = 0;
+        int32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct event {
+        event_type type = event_type::e_NONE;
+        key_code key = key_code::e_NONE;
+        mouse_code button = mouse_code::e_NONE;
+
+        // e_resize, e_resize_end: width and height
+        // e_mouse_button_*, e_mouse_move: cursor position
+        // e_mouse_scroll_*: delta in x
+        int32_t x = 0;
+        int32_t y = 0;
+
+        // Milliseconds on the X server clock, events without their own timestamp carry the
+        // time of the latest one that had
+        uint32_t time = 0;
+    };
+
+    struct pointer_sample {
+        int32_t x = 0;
+        int32_t y = 0;
+        // Milliseconds on the X server clock
+        uint32_t time = 0;
+    };
+
+    // Batches are copied around and handed across threads as plain memory
+    static_assert(std::is_trivially_copyable_v<event> && sizeof(event) == 16);
+} // namespace sw
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <xcb/xcb.h>
+
+namespace sw {
+    enum class replay_pacing : std::uint8_t { e_realtime, e_unpaced };
+
+    // Records the events a window dispatches into a memory mapped log. Every record stores the
+    // time since the previous record and the event xor'ed against the last event of the same
+    // type, only the bytes that changed are written so a motion event takes a few bytes.
+    //
+    // Window, atom and extension event numbers are those of the recording session, replay
+    // skips the events that carry them.
+    class input_recorder {
+    public:
+        explicit input_recorder(const char* path);
+        ~input_recorder();
+
+        input_recorder(const input_recorder&) = delete;
+        input_recorder& operator=(const input_recorder&) = delete;
+
+        void record(const xcb_generic_event_t* event);
+
+        // Truncates the file to the written size, recording afterwards is ignored
+        void close();
+
+        std::size_t get_event_count() const { return m_event_count; }
+        std::size_t get_size() const { return m_size; }
+
+    private:
+        void commit();
+        uint8_t* reserve(std::size_t size);
+        void put_varint(uint64_t value);
+
+    private:
+        int m_fd = -1;
+        uint8_t* m_data = nullptr;
+        std::size_t m_capacity = 0;
+        std::size_t m_size = 0;
+        std::size_t m_event_count = 0;
+
+        std::chrono::steady_clock::time_point m_last_time;
+        uint8_t m_previous[128][32] = {};
+    };
+
+    // Reads a log written by input_recorder back into events the dispatch loop takes
+    class input_replayer {
+    public:
+        explicit input_replayer(const char* path, replay_pacing pacing = replay_pacing::e_realtime);
+        ~input_replayer();
+
+        input_replayer(const input_replayer&) = delete;
+        input_replayer& operator=(const input_replayer&) = delete;
+
+        // Returns the next event allocated with malloc, or nullptr when the log is finished or
+        // in real time replay the next event is not due yet
+        xcb_generic_event_t* next();
+
+        // Starts over from the beginning, real time replay is paced from this call
+        void rewind();
+
+        // When the next event is due, lets a replay loop sleep instead of polling next().
+        // Unpaced and finished replays are always due.
+        std::chrono::steady_clock::time_point get_next_time();
+
+        bool is_finished() const { return m_offset >= m_size; }
+
+    private:
+        bool get_varint(uint64_t& value);
+
+    private:
+        uint8_t* m_data = nullptr;
+        std::size_t m_mapped_size = 0;
+        std::size_t m_size = 0;
+        std::size_t m_offset = 0;
+        replay_pacing m_pacing;
+
+        std::chrono::steady_clock::time_point m_start;
+        std::chrono::microseconds m_elapsed{0};
+        uint8_t m_previous[128][32] = {};
+    };
+} // namespace sw
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+namespace sw {
+    struct monitor {
+        int32_t x = 0;
+        int32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // In Hz, 0 if unknown
+        double refresh_rate = 0.0;
+        bool primary = false;
+    };
+} // namespace sw
\ No newline at end of file
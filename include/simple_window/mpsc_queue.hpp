@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace sw::detail {
+    // Intrusive multi producer single consumer queue (Vyukov). Pushing is wait-free from any
+    // thread, popping is only allowed from the single consumer thread.
+    template <typename T>
+    class mpsc_queue {
+    private:
+        struct node {
+            std::atomic<node*> next{nullptr};
+        };
+
+        struct value_node : node {
+            explicit value_node(T&& v) : value(std::move(v)) {}
+            T value;
+        };
+
+    public:
+        mpsc_queue() : m_head(&m_stub), m_tail(&m_stub) {}
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        ~mpsc_queue() {
+            T value;
+            while (pop(value)) {
+            }
+        }
+
+        void push(T value) { push_node(new value_node(std::move(value))); }
+
+        bool pop(T& out) {
+            node* tail = m_tail;
+            node* next = tail->next.load(std::memory_order_acquire);
+
+            if (tail == &m_stub) {
+                if (next == nullptr) {
+                    return false;
+                }
+                m_tail = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next == nullptr) {
+                // A producer is between exchanging the head and linking its node
+                if (tail != m_head.load(std::memory_order_acquire)) {
+                    return false;
+                }
+
+                push_node(&m_stub);
+                next = tail->next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    return false;
+                }
+            }
+
+            m_tail = next;
+            auto* value = static_cast<value_node*>(tail);
+            out = std::move(value->value);
+            delete value;
+            return true;
+        }
+
+    private:
+        void push_node(node* n) {
+            n->next.store(nullptr, std::memory_order_relaxed);
+            node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+            prev->next.store(n, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<node*> m_head;
+        node* m_tail;
+        node m_stub;
+    };
+} // namespace sw::detail
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sw::detail {
+    // Single writer seqlock. The value is stored as relaxed atomic words so readers on other
+    // threads never race, they retry only when a read overlaps a store.
+    template <typename T>
+    class alignas(64) seqlock {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        void store(const T& value) {
+            uint64_t words[word_count] = {};
+            std::memcpy(words, &value, sizeof(T));
+
+            const auto seq = m_seq.load(std::memory_order_relaxed);
+            m_seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (std::size_t i = 0; i < word_count; ++i) {
+                m_words[i].store(words[i], std::memory_order_relaxed);
+            }
+
+            m_seq.store(seq + 2, std::memory_order_release);
+        }
+
+        T load() const {
+            uint64_t words[word_count];
+            uint32_t before, after;
+            do {
+                before = m_seq.load(std::memory_order_acquire);
+                for (std::size_t i = 0; i < word_count; ++i) {
+                    words[i] = m_words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = m_seq.load(std::memory_order_relaxed);
+            } while ((before & 1) != 0 || before != after);
+
+            T value;
+            std::memcpy(&value, words, sizeof(T));
+            return value;
+        }
+
+    private:
+        static constexpr std::size_t word_count = (sizeof(T) + 7) / 8;
+
+        std::atomic<uint32_t> m_seq{0};
+        std::atomic<uint64_t> m_words[word_count] = {};
+    };
+} // namespace sw::detail
\ No newline at end of file
@@ -1,7 +1,41 @@
 #pragma once
 
-#if defined(_WIN32)
+#if defined(SW_NULL_BACKEND)
+#    include "simple_window/window_null_interface.hpp"
+#elif defined(_WIN32)
 #    include "simple_window/window_win32_interface.hpp"
+#    include "simple_window/window_null_interface.hpp"
 #elif defined(__linux__)
 #    include "simple_window/window_xcb_interface.hpp"
+#    include "simple_window/window_null_interface.hpp"
 #endif
+
+#include <cstdlib>
+#include <cstring>
+
+namespace sw {
+#if defined(SW_NULL_BACKEND)
+    using null::window_interface;
+#endif
+
+    // Backend to run with when the same binary has to work with and without a display.
+    // SIMPLE_WINDOW_BACKEND=null forces the null backend, otherwise it is picked when no
+    // display can be reached. Windows written against a template base choose between
+    // sw::window_interface and sw::null::window_interface with it.
+    inline backend select_backend() {
+#if defined(SW_NULL_BACKEND)
+        return backend::e_null;
+#else
+        const char* selected = std::getenv("SIMPLE_WINDOW_BACKEND");
+        if (selected != nullptr && std::strcmp(selected, "null") == 0) {
+            return backend::e_null;
+        }
+#    if defined(__linux__)
+        if (!detail::window_xcb::is_display_available()) {
+            return backend::e_null;
+        }
+#    endif
+        return backend::e_native;
+#endif
+    }
+} // namespace sw
\ No newline at end of file
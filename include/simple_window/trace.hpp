@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Spans and markers for lining up window system activity with a render timeline. Built with
+// SW_TRACING (SIMPLE_WINDOW_TRACING in CMake) every thread records into its own buffer without
+// locking and write_chrome_json or write_perfetto flush all buffers on demand. Without it the
+// macros expand to nothing and the functions are empty.
+//
+// Names and details are not copied, they have to be string literals or outlive the flush.
+// Timestamps are std::chrono::steady_clock, CLOCK_MONOTONIC on Linux.
+//
+//     sw::trace::start();
+//     SW_TRACE_BEGIN("frame");
+//     ...
+//     SW_TRACE_END("frame");
+//     SW_TRACE_INSTANT("present");
+//     sw::trace::write_perfetto("frames.pftrace");
+
+#define SW_TRACE_CONCAT_IMPL(a, b) a##b
+#define SW_TRACE_CONCAT(a, b) SW_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(SW_TRACING)
+#    define SW_TRACE_SCOPE(name)                                                                 \
+        ::sw::trace::detail::scope SW_TRACE_CONCAT(sw_trace_scope_, __LINE__)(name, nullptr)
+#    define SW_TRACE_SCOPE_ARG(name, text)                                                       \
+        ::sw::trace::detail::scope SW_TRACE_CONCAT(sw_trace_scope_, __LINE__)(name, text)
+#    define SW_TRACE_BEGIN(name)                                                                 \
+        ::sw::trace::detail::record(::sw::trace::detail::phase::e_begin, name)
+#    define SW_TRACE_END(name)                                                                   \
+        ::sw::trace::detail::record(::sw::trace::detail::phase::e_end, name)
+#    define SW_TRACE_INSTANT(name)                                                               \
+        ::sw::trace::detail::record(::sw::trace::detail::phase::e_instant, name)
+#else
+#    define SW_TRACE_SCOPE(name)
+#    define SW_TRACE_SCOPE_ARG(name, text)
+#    define SW_TRACE_BEGIN(name)
+#    define SW_TRACE_END(name)
+#    define SW_TRACE_INSTANT(name)
+#endif
+
+namespace sw::trace {
+#if defined(SW_TRACING)
+    // Clears what was recorded and starts recording, each thread keeps at most
+    // events_per_thread events and drops the rest. Waits for a write in progress.
+    void start(std::size_t events_per_thread = std::size_t(1) << 16);
+    void stop();
+
+    // Shown as the track name, the calling thread is named
+    void set_thread_name(const char* name);
+
+    // Write everything recorded since start, false if the file could not be written. Call
+    // from one thread at a time, recording on other threads continues meanwhile.
+    bool write_chrome_json(const char* path);
+    bool write_perfetto(const char* path);
+
+    // Events lost to full buffers since start
+    std::size_t get_dropped_count();
+#else
+    inline void start(std::size_t = 0) {}
+    inline void stop() {}
+    inline void set_thread_name(const char*) {}
+    inline bool write_chrome_json(const char*) { return false; }
+    inline bool write_perfetto(const char*) { return false; }
+    inline std::size_t get_dropped_count() { return 0; }
+#endif
+} // namespace sw::trace
+
+#if defined(SW_TRACING)
+namespace sw::trace::detail {
+    enum class phase : uint8_t { e_begin, e_end, e_instant };
+
+    inline std::atomic<bool> g_enabled{false};
+
+    void append(phase ph, const char* name, const char* detail);
+
+    inline void record(phase ph, const char* name) {
+        if (g_enabled.load(std::memory_order_relaxed)) {
+            append(ph, name, nullptr);
+        }
+    }
+
+    // A span that started before tracing did is not ended either
+    class scope {
+    public:
+        scope(const char* name, const char* detail)
+            : m_name(name), m_active(g_enabled.load(std::memory_order_relaxed)) {
+            if (m_active) {
+                append(phase::e_begin, name, detail);
+            }
+        }
+        ~scope() {
+            if (m_active) {
+                append(phase::e_end, m_name, nullptr);
+            }
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        const char* m_name;
+        bool m_active;
+    };
+} // namespace sw::trace::detail
+#endif
\ No newline at end of file
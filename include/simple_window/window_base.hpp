@@ -1,17 +1,52 @@
 #pragma once
+#include "simple_window/seqlock.hpp"
+
 #include <string>
 #include <utility>
 #include <stdexcept>
 
+namespace sw {
+    // Consistent copy of the window and input state, see window_base::get_state_snapshot
+    struct window_state {
+        int32_t mouse_x = 0;
+        int32_t mouse_y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t flags = 0;
+
+        inline bool is_open() const { return (0b1 & flags); }
+        inline bool is_fullscreen() const { return (0b10 & flags); }
+        inline bool is_cursor_locked() const { return (0b100 & flags); }
+        inline bool needs_redraw() const { return (0b1000 & flags); }
+        inline bool is_visible() const { return (0b10000 & flags); }
+
+        bool operator==(const window_state& other) const {
+            return mouse_x == other.mouse_x && mouse_y == other.mouse_y &&
+                   width == other.width && height == other.height && flags == other.flags;
+        }
+        bool operator!=(const window_state& other) const { return !(*this == other); }
+    };
+} // namespace sw
+
 namespace sw::detail {
     class window_base {
     public:
-        window_base(uint32_t width, uint32_t height) : m_width(width), m_height(height) {}
+        window_base(uint32_t width, uint32_t height) : m_width(width), m_height(height) {
+            publish_state();
+        }
 
         inline bool is_open() const { return (0b1 & m_flags); }
         inline bool is_fullscreen() const { return (0b10 & m_flags); }
         inline bool is_cursor_locked() const { return (0b100 & m_flags); }
 
+        // Set when content was exposed or resized, event driven applications render only then
+        inline bool needs_redraw() const { return (0b1000 & m_flags); }
+        inline void request_redraw() { m_flags |= 0b1000; }
+        inline void mark_redrawn() { m_flags &= 0b11110111; }
+
+        // False while the window is unmapped, minimized or fully covered
+        inline bool is_visible() const { return (0b10000 & m_flags); }
+
         inline uint32_t get_width() const { return m_width; }
         inline uint32_t get_height() const { return m_height; }
 
@@ -19,6 +54,9 @@ namespace sw::detail {
         inline int32_t get_mouse_y() const { return m_mouse_y; }
         inline std::pair<int32_t, int32_t> get_mouse_pos() const { return {m_mouse_x, m_mouse_y}; }
 
+        // Safe to call from any thread, returns the state as of the end of the last poll
+        inline window_state get_state_snapshot() const { return m_published_state.load(); }
+
     protected:
         inline void set_open_flag_true() { m_flags |= 0b1; }
         inline void set_open_flag_false() { m_flags &= 0b11111110; }
@@ -29,6 +67,9 @@ namespace sw::detail {
         inline void set_cursor_flag_true() { m_flags |= 0b100; }
         inline void set_cursor_flag_false() { m_flags &= 0b11111011; }
 
+        inline void set_visible_flag_true() { m_flags |= 0b10000; }
+        inline void set_visible_flag_false() { m_flags &= 0b11101111; }
+
         void handle_mouse_move(int new_x, int new_y) {
             m_last_cursor_x = m_mouse_x;
             m_last_cursor_y = m_mouse_y;
@@ -37,9 +78,19 @@ namespace sw::detail {
             m_mouse_y = new_y;
         }
 
+        // Called by the owning thread once per poll, readers only retry while a store overlaps
+        void publish_state() {
+            const window_state state = {m_mouse_x, m_mouse_y, m_width, m_height, m_flags};
+            if (state != m_last_published_state) {
+                m_last_published_state = state;
+                m_published_state.store(state);
+            }
+        }
+
     private:
-        // 0b1: open, 0b10: fullscreen, 0b100: cursor_locked
-        uint8_t m_flags = 0b1;
+        // 0b1: open, 0b10: fullscreen, 0b100: cursor_locked, 0b1000: needs_redraw,
+        // 0b10000: visible, set by the backend once the window is actually shown
+        uint8_t m_flags = 0b01001;
 
     protected:
         uint32_t m_width;
@@ -49,5 +100,9 @@ namespace sw::detail {
         int32_t m_mouse_y = 0;
         int32_t m_last_cursor_x = 0;
         int32_t m_last_cursor_y = 0;
+
+    private:
+        window_state m_last_published_state;
+        seqlock<window_state> m_published_state;
     };
 } // namespace sw::detail
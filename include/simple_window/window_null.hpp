@@ -0,0 +1,130 @@
+#pragma once
+#include "simple_window/window_base.hpp"
+#include "simple_window/enums.hpp"
+#include "simple_window/event.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sw::detail {
+    // Backend without a display, for CI and render nodes. Input comes from inject_event and
+    // rendering goes to a CPU framebuffer or a VK_EXT_headless_surface.
+    class window_null : public window_base {
+    protected:
+        window_null(const char* name, uint32_t width, uint32_t height);
+
+    public:
+        // Instance extension to enable instead of the platform surface extension, surfaces are
+        // created with vkCreateHeadlessSurfaceEXT
+        static constexpr const char* vulkan_surface_extension = "VK_EXT_headless_surface";
+
+        // Queued and dispatched by the next poll like an event from a display server. Safe to
+        // call from any thread. Events without a time get the milliseconds since creation.
+        void inject_event(const event& e);
+
+        // Pixels in 0xAARRGGBB, get_width() per row. Reallocated when a resize is dispatched.
+        uint32_t* get_framebuffer() { return m_framebuffer.data(); }
+        const uint32_t* get_framebuffer() const { return m_framebuffer.data(); }
+
+        // Size changes are delivered by the next poll as a resize followed by its resize end,
+        // like a window manager would configure
+        void set_size(uint32_t width, uint32_t height);
+        void set_fullscreen(bool fullscreen);
+
+        // There is no window manager, size hints are accepted and ignored
+        void set_min_size(uint32_t, uint32_t) {}
+        void set_max_size(uint32_t, uint32_t) {}
+        void set_aspect_ratio(uint32_t, uint32_t) {}
+        void set_resize_increment(uint32_t, uint32_t) {}
+
+        // Resizes are never coalesced or deferred
+        void set_resize_throttle(std::chrono::milliseconds) {}
+        void set_resize_end_delay(std::chrono::milliseconds) {}
+
+        // There is no compositor to synchronize with
+        bool is_sync_request_pending() const { return false; }
+        void ack_sync_request() {}
+
+        // Injected events change the input state only when dispatched, the latched snapshot
+        // is the dispatched one
+        void latch_input() {}
+        int32_t get_latched_mouse_x() const { return m_mouse_x; }
+        int32_t get_latched_mouse_y() const { return m_mouse_y; }
+
+        // The window is never hidden, so nothing blocks
+        void set_block_while_hidden(bool) {}
+
+        void lock_cursor() { set_cursor_flag_true(); }
+        void unlock_cursor() { set_cursor_flag_false(); }
+        void hide_cursor() { m_cursor_hidden = true; }
+        void show_cursor() { m_cursor_hidden = false; }
+        bool is_cursor_hidden() const { return m_cursor_hidden; }
+        void set_cursor_image(cursor_icon cursor) { m_cursor = cursor; }
+        cursor_icon get_cursor_image() const { return m_cursor; }
+
+        // Generates the motion event a server would send after warping, screenspace is ignored
+        void set_cursor_pos(int32_t x, int32_t y, bool screenspace);
+
+        // The selections are local to the window
+        std::string get_clipboard() const { return m_clipboard[0]; }
+        void set_clipboard(const std::string& data,
+                           clipboard_selection selection = clipboard_selection::e_clipboard) {
+            m_clipboard[static_cast<int>(selection)] = data;
+        }
+        // The text is delivered by the next poll through on_clipboard(std::string_view chunk,
+        // bool finished) in one finished chunk. Returns false while another read is pending.
+        bool request_clipboard(clipboard_selection selection = clipboard_selection::e_clipboard);
+
+        std::string get_name() const { return m_name; }
+        void set_name(const std::string& name) { m_name = name; }
+
+        // Nothing is deferred, there is no timeout to wait for
+        int get_dispatch_timeout() const { return -1; }
+
+        // Window pooling, suspend drops queued events and reports closed until resume
+        void suspend();
+        void resume(const char* name, uint32_t width, uint32_t height);
+
+    protected:
+        // Moves the injected events behind the ones already taken
+        void take_injected(std::vector<event>& events);
+        // Blocks until an event is injected or the timeout in milliseconds passed, -1 waits
+        // without a timeout
+        void wait_injected(int timeout_ms);
+
+        // Applies the window state an event carries before it reaches the callbacks
+        void apply_event(const event& e);
+
+        // Text of the selection a request_clipboard call asked for, once per call
+        bool take_clipboard_request(std::string_view& data);
+
+    private:
+        uint32_t elapsed_ms() const;
+        // Drops injected and taken events and a pending clipboard request
+        void drop_events();
+
+    protected:
+        // Events taken from the injected queue, dispatched up to the offset
+        std::vector<event> m_pending;
+        std::size_t m_pending_offset = 0;
+
+    private:
+        std::string m_name;
+        std::string m_clipboard[2];
+        int m_clipboard_request = -1;
+        cursor_icon m_cursor = cursor_icon::e_arrow;
+        bool m_cursor_hidden = false;
+
+        std::vector<uint32_t> m_framebuffer;
+        std::chrono::steady_clock::time_point m_created;
+
+        std::mutex m_injected_mutex;
+        std::condition_variable m_injected_signal;
+        std::vector<event> m_injected;
+    };
+} // namespace sw::detail
\ No newline at end of file
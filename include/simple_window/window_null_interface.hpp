@@ -0,0 +1,475 @@
+#pragma once
+#include "simple_window/window_null.hpp"
+#include "simple_window/action_map.hpp"
+#include "simple_window/event.hpp"
+#include "simple_window/trace.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#    include <span>
+#endif
+
+namespace sw::null {
+    // Same surface as the display backends, callbacks are driven by the injected events.
+    // Injected events carry no text, window position or visibility, so on_char, on_move and
+    // on_visibility_change may be defined but are never called.
+    template <typename Window>
+    class window_interface : public detail::window_null {
+    protected:
+        // The visual is only used by the xcb backend
+        window_interface(const char* name, uint32_t width, uint32_t height,
+                         window_visual = window_visual::e_opaque)
+            : window_null(name, width, height) {}
+
+        void poll_events() { dispatch_events(); }
+
+        // Dispatches like poll_events and additionally writes every event into the array,
+        // returns how many were written. Events that do not fit stay queued for the next call.
+        std::size_t poll_events(event* events, std::size_t capacity) {
+            m_event_batch = events;
+            m_event_batch_capacity = capacity;
+            m_event_batch_size = 0;
+            dispatch_events();
+            m_event_batch = nullptr;
+            return m_event_batch_size;
+        }
+
+#if defined(__cpp_lib_span)
+        std::span<event> poll_events(std::span<event> events) {
+            return events.first(poll_events(events.data(), events.size()));
+        }
+#endif
+
+        // Blocks until an event is injected, then dispatches
+        void wait_events() {
+            if (m_pending_offset == m_pending.size()) {
+                wait_injected(-1);
+            }
+            dispatch_events();
+        }
+
+        // Key and mouse button input is run through the map and delivered to
+        // on_action(action_id, action_phase), the map must outlive the window or be reset
+        void set_action_map(action_map* map) { m_action_map = map; }
+
+    private:
+        void dispatch_events() {
+            SW_TRACE_SCOPE("dispatch_events");
+            take_injected(m_pending);
+
+            while (m_pending_offset < m_pending.size()) {
+                if (m_event_batch != nullptr && m_event_batch_size == m_event_batch_capacity) {
+                    break;
+                }
+                process_event(m_pending[m_pending_offset++]);
+            }
+
+            if (m_pending_offset == m_pending.size()) {
+                m_pending.clear();
+                m_pending_offset = 0;
+            }
+
+            std::string_view clipboard;
+            if (take_clipboard_request(clipboard)) {
+                if constexpr (has_on_clipboard::value) {
+                    SW_TRACE_SCOPE("on_clipboard");
+                    static_cast<Window*>(this)->on_clipboard(clipboard, true);
+                }
+            }
+
+            publish_state();
+        }
+
+        void process_event(const event& e) {
+            SW_TRACE_SCOPE("process_event");
+            apply_event(e);
+
+            switch (e.type) {
+                case event_type::e_close: {
+                    if constexpr (has_on_close::value) {
+                        SW_TRACE_SCOPE("on_close");
+                        static_cast<Window*>(this)->on_close();
+                    }
+                    break;
+                }
+                case event_type::e_resize: {
+                    if constexpr (has_on_resize::value) {
+                        SW_TRACE_SCOPE("on_resize");
+                        static_cast<Window*>(this)->on_resize(m_width, m_height);
+                    }
+                    // The framebuffer was reallocated, all of it has to be drawn again
+                    if constexpr (has_on_expose::value) {
+                        SW_TRACE_SCOPE("on_expose");
+                        const rect exposed = {0, 0, m_width, m_height};
+                        static_cast<Window*>(this)->on_expose(&exposed, std::size_t(1));
+                    }
+                    break;
+                }
+                case event_type::e_resize_end: {
+                    if constexpr (has_on_resize_end::value) {
+                        SW_TRACE_SCOPE("on_resize_end");
+                        static_cast<Window*>(this)->on_resize_end(m_width, m_height);
+                    }
+                    break;
+                }
+                case event_type::e_focus_in: {
+                    if constexpr (has_on_focus_in::value) {
+                        SW_TRACE_SCOPE("on_focus_in");
+                        static_cast<Window*>(this)->on_focus_in();
+                    }
+                    break;
+                }
+                case event_type::e_focus_out: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release_all(action_callback());
+                        }
+                    }
+                    if constexpr (has_on_focus_out::value) {
+                        SW_TRACE_SCOPE("on_focus_out");
+                        static_cast<Window*>(this)->on_focus_out();
+                    }
+                    break;
+                }
+                case event_type::e_key_down: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->press(e.key, action_callback());
+                        }
+                    }
+                    if constexpr (has_on_key_down::value) {
+                        SW_TRACE_SCOPE("on_key_down");
+                        static_cast<Window*>(this)->on_key_down(e.key);
+                    }
+                    break;
+                }
+                case event_type::e_key_up: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release(e.key, action_callback());
+                        }
+                    }
+                    if constexpr (has_on_key_up::value) {
+                        SW_TRACE_SCOPE("on_key_up");
+                        static_cast<Window*>(this)->on_key_up(e.key);
+                    }
+                    break;
+                }
+                case event_type::e_mouse_button_down: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->press(e.button, action_callback());
+                        }
+                    }
+                    if constexpr (has_on_mouse_button_down::value) {
+                        SW_TRACE_SCOPE("on_mouse_button_down");
+                        static_cast<Window*>(this)->on_mouse_button_down(e.button, e.x, e.y);
+                    }
+                    break;
+                }
+                case event_type::e_mouse_button_up: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release(e.button, action_callback());
+                        }
+                    }
+                    if constexpr (has_on_mouse_button_up::value) {
+                        SW_TRACE_SCOPE("on_mouse_button_up");
+                        static_cast<Window*>(this)->on_mouse_button_up(e.button, e.x, e.y);
+                    }
+                    break;
+                }
+                case event_type::e_mouse_scroll_v: {
+                    if constexpr (has_on_mouse_scroll_v::value) {
+                        SW_TRACE_SCOPE("on_mouse_scroll_v");
+                        static_cast<Window*>(this)->on_mouse_scroll_v(e.x);
+                    }
+                    break;
+                }
+                case event_type::e_mouse_scroll_h: {
+                    if constexpr (has_on_mouse_scroll_h::value) {
+                        SW_TRACE_SCOPE("on_mouse_scroll_h");
+                        static_cast<Window*>(this)->on_mouse_scroll_h(e.x);
+                    }
+                    break;
+                }
+                case event_type::e_mouse_move: {
+                    if constexpr (has_on_mouse_move_pos::value) {
+                        SW_TRACE_SCOPE("on_mouse_move_pos");
+                        static_cast<Window*>(this)->on_mouse_move_pos(m_mouse_x, m_mouse_y);
+                    }
+                    if constexpr (has_on_mouse_move_delta::value) {
+                        SW_TRACE_SCOPE("on_mouse_move_delta");
+                        static_cast<Window*>(this)->on_mouse_move_delta(
+                            m_mouse_x - m_last_cursor_x, m_mouse_y - m_last_cursor_y);
+                    }
+                    break;
+                }
+                default: break;
+            }
+
+            if (m_event_batch != nullptr) {
+                m_event_batch[m_event_batch_size++] = e;
+            }
+            if constexpr (has_on_event::value) {
+                SW_TRACE_SCOPE("on_event");
+                static_cast<Window*>(this)->on_event(e);
+            }
+        }
+
+        inline auto action_callback() {
+            return [this](const action_id action, const action_phase phase) {
+                SW_TRACE_SCOPE("on_action");
+                static_cast<Window*>(this)->on_action(action, phase);
+            };
+        }
+
+    private:
+        event* m_event_batch = nullptr;
+        std::size_t m_event_batch_capacity = 0;
+        std::size_t m_event_batch_size = 0;
+
+        action_map* m_action_map = nullptr;
+
+        class has_on_event {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_event));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_resize {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_resize));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_resize_end {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_resize_end));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_close {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_close));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_focus_in {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_focus_in));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_focus_out {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_focus_out));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_key_down {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_key_down));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_key_up {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_key_up));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_button_down {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_button_down));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_button_up {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_button_up));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_move_pos {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_move_pos));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_move_delta {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_move_delta));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_scroll_v {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_scroll_v));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_mouse_scroll_h {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_mouse_scroll_h));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_expose {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_expose));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_clipboard {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_clipboard));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_action {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_action));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+    };
+} // namespace sw::null
\ No newline at end of file
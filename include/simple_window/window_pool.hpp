@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sw {
+    // Keeps released windows suspended instead of destroying them, so transient windows like
+    // tooltips and popups skip connecting, window creation and atom round trips when they are
+    // opened again. A pooled window is the same Window object with its connection and X window,
+    // acquire resumes it with a new name and size and everything else it was configured with
+    // stays. Not thread-safe, windows are acquired and released on the thread polling them.
+    template <typename Window>
+    class window_pool {
+    public:
+        explicit window_pool(std::size_t capacity = 8) : m_capacity(capacity) {
+            m_windows.reserve(capacity);
+        }
+
+        window_pool(const window_pool&) = delete;
+        window_pool& operator=(const window_pool&) = delete;
+
+        // Resumes the most recently released window, or constructs one with
+        // Window(name, width, height, args...) when the pool is empty
+        template <typename... Args>
+        std::unique_ptr<Window> acquire(const char* name, uint32_t width, uint32_t height,
+                                        Args&&... args) {
+            if (m_windows.empty()) {
+                return std::make_unique<Window>(name, width, height, std::forward<Args>(args)...);
+            }
+
+            auto window = std::move(m_windows.back());
+            m_windows.pop_back();
+            window->resume(name, width, height);
+            return window;
+        }
+
+        // Suspends the window and keeps it, a full pool destroys it instead
+        void release(std::unique_ptr<Window> window) {
+            if (window == nullptr) {
+                return;
+            }
+            if (m_windows.size() >= m_capacity) {
+                return;
+            }
+
+            window->suspend();
+            m_windows.push_back(std::move(window));
+        }
+
+        void clear() { m_windows.clear(); }
+
+        std::size_t size() const { return m_windows.size(); }
+        std::size_t capacity() const { return m_capacity; }
+
+    private:
+        std::size_t m_capacity;
+        std::vector<std::unique_ptr<Window>> m_windows;
+    };
+} // namespace sw
\ No newline at end of file
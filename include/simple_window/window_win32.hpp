@@ -2,6 +2,8 @@
 #include "simple_window/window_base.hpp"
 #include "simple_window/enums.hpp"
 
+#include <string_view>
+
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #define VC_EXTRALEAN
@@ -16,8 +18,13 @@ namespace sw::detail {
         ~window_win32();
 
         void poll_events();
+        void wait_events();
         key_code code_to_enum(const uint64_t code, const int64_t param) const;
 
+        // UTF-8 text of a WM_CHAR code unit, empty for the first half of a surrogate pair. The
+        // view points into a fixed buffer and stays valid until the next call.
+        std::string_view translate_char(WPARAM code);
+
     public:
         HWND get_hwnd() const { return m_handle; }
         HINSTANCE get_hinstance() const { return GetModuleHandle(NULL); }
@@ -77,5 +84,9 @@ namespace sw::detail {
 
     protected:
         HWND m_handle;
+
+    private:
+        wchar_t m_high_surrogate = 0;
+        char m_char_text[4] = {};
     };
 } // namespace sw::detail
\ No newline at end of file
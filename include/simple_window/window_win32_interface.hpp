@@ -1,13 +1,20 @@
 #pragma once
 #include "simple_window/window_win32.hpp"
+#include "simple_window/action_map.hpp"
 
 namespace sw {
     template <typename Window>
     class window_interface : public detail::window_win32 {
     protected:
-        window_interface(const char* name, uint32_t width, uint32_t height)
+        // The visual is only used by the xcb backend
+        window_interface(const char* name, uint32_t width, uint32_t height,
+                         window_visual = window_visual::e_opaque)
             : window_win32(name, width, height, &window_proc) {}
 
+        // Key and mouse button input is run through the map and delivered to
+        // on_action(action_id, action_phase), the map must outlive the window or be reset
+        void set_action_map(action_map* map) { m_action_map = map; }
+
     private:
         static LRESULT CALLBACK window_proc(HWND window, UINT msg, WPARAM wParam, LPARAM lParam) {
             if (auto ptr = GetWindowLongPtr(window, GWLP_USERDATA)) {
@@ -22,6 +29,13 @@ namespace sw {
                 // Keyboard
                 case WM_SYSKEYDOWN:
                 case WM_KEYDOWN: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr && !(lParam & 0x40000000)) {
+                            m_action_map->press(code_to_enum(static_cast<uint64_t>(wParam),
+                                                             static_cast<int64_t>(lParam)),
+                                                action_callback());
+                        }
+                    }
                     if constexpr (has_on_key_down::value) {
                         if (!(lParam & 0x40000000)) {
                             static_cast<Window*>(this)->on_key_down(code_to_enum(
@@ -32,6 +46,13 @@ namespace sw {
                 }
                 case WM_SYSKEYUP:
                 case WM_KEYUP: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release(code_to_enum(static_cast<uint64_t>(wParam),
+                                                               static_cast<int64_t>(lParam)),
+                                                  action_callback());
+                        }
+                    }
                     if constexpr (has_on_key_up::value) {
                         static_cast<Window*>(this)->on_key_up(code_to_enum(
                             static_cast<uint64_t>(wParam), static_cast<int64_t>(lParam)));
@@ -40,9 +61,10 @@ namespace sw {
                 }
 
                 case WM_CHAR: {
+                    // UTF-8 like the other backends, surrogate pairs arrive as two messages
                     if constexpr (has_on_char::value) {
-                        if (wParam > 0 && wParam < 0x10000) {
-                            static_cast<Window*>(this)->on_char(static_cast<wchar_t>(wParam));
+                        if (auto text = translate_char(wParam); !text.empty()) {
+                            static_cast<Window*>(this)->on_char(text);
                         }
                     }
                     break;
@@ -117,9 +139,15 @@ namespace sw {
                 }
 
                 // System
+                case WM_PAINT: {
+                    request_redraw();
+                    break;
+                }
+
                 case WM_SIZE: {
                     m_width = static_cast<uint32_t>(LOWORD(lParam));
                     m_height = static_cast<uint32_t>(HIWORD(lParam));
+                    request_redraw();
                     if constexpr (has_on_resize::value) {
                         static_cast<Window*>(this)->on_resize(m_width, m_height);
                     }
@@ -150,6 +178,11 @@ namespace sw {
                 }
 
                 case WM_KILLFOCUS: {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release_all(action_callback());
+                        }
+                    }
                     if constexpr (has_on_focus_out::value) {
                         if (is_open()) {
                             static_cast<Window*>(this)->on_focus_out();
@@ -162,7 +195,18 @@ namespace sw {
             return DefWindowProc(window, msg, wParam, lParam);
         }
 
+        inline auto action_callback() {
+            return [this](const action_id action, const action_phase phase) {
+                static_cast<Window*>(this)->on_action(action, phase);
+            };
+        }
+
         inline void handle_mouse_down_event(const mouse_code code, LPARAM lparam) {
+            if constexpr (has_on_action::value) {
+                if (m_action_map != nullptr) {
+                    m_action_map->press(code, action_callback());
+                }
+            }
             if constexpr (has_on_mouse_button_down::value) {
                 const auto x = static_cast<int32_t>(LOWORD(lparam));
                 const auto y = static_cast<int32_t>(HIWORD(lparam));
@@ -171,6 +215,11 @@ namespace sw {
         }
 
         inline void handle_mouse_up_event(const mouse_code code, LPARAM lparam) {
+            if constexpr (has_on_action::value) {
+                if (m_action_map != nullptr) {
+                    m_action_map->release(code, action_callback());
+                }
+            }
             if constexpr (has_on_mouse_button_up::value) {
                 const auto x = static_cast<int32_t>(LOWORD(lparam));
                 const auto y = static_cast<int32_t>(HIWORD(lparam));
@@ -250,6 +299,20 @@ namespace sw {
 
         // Keyboard
 
+        class has_on_action {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_action));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
         class has_on_key_down {
         private:
             typedef char YesType[1];
@@ -377,5 +440,8 @@ namespace sw {
         public:
             enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
         };
+
+    private:
+        action_map* m_action_map = nullptr;
     };
 } // namespace sw
\ No newline at end of file
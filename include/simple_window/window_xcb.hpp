@@ -1,22 +1,85 @@
 #pragma once
 #include "simple_window/window_base.hpp"
 #include "simple_window/enums.hpp"
+#include "simple_window/event.hpp"
+#include "simple_window/monitor.hpp"
+#include "simple_window/mpsc_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 #include <xcb/xcb.h>
+#include <xcb/sync.h>
+
+struct xkb_context;
+struct xkb_keymap;
+struct xkb_state;
+struct xkb_compose_table;
+struct xkb_compose_state;
+
+namespace sw {
+    // Constructs a window without a server connection, events are supplied with inject_event.
+    // Lets benchmarks and tests drive the dispatch path with synthetic event streams.
+    struct detached_t {
+        explicit detached_t() = default;
+    };
+    inline constexpr detached_t detached{};
+} // namespace sw
 
 namespace sw::detail {
     class window_xcb : public window_base {
     protected:
-        window_xcb(const char* name, uint32_t width, uint32_t height);
+        window_xcb(const char* name, uint32_t width, uint32_t height,
+                   window_visual visual = window_visual::e_opaque, bool sync_request = false,
+                   bool drop_target = false, bool text_input = false);
+        // Only the dispatch path is usable, requests go to an error connection so they are
+        // dropped and every reply is null. Atoms are XCB_NONE and calls that need the screen,
+        // like cursor changes, warps, fullscreen and resume, do nothing.
+        window_xcb(detached_t, uint32_t width, uint32_t height);
         ~window_xcb();
 
     public:
+        // Whether a connection to the display server can be made
+        static bool is_display_available();
+
         xcb_connection_t* get_connection() const { return m_connection; }
         xcb_window_t get_window() const { return m_window; }
+        xcb_visualid_t get_visual_id() const { return m_visual_id; }
+        uint8_t get_depth() const { return m_depth; }
+
+        // File descriptor of the X connection, readable when new events arrive
+        int get_fd() const { return xcb_get_file_descriptor(m_connection); }
+
+        // Window position in root coordinates
+        int32_t get_x() const { return m_x; }
+        int32_t get_y() const { return m_y; }
 
         void set_size(uint32_t width, uint32_t height);
+        // Covers the monitor the window is on
         void set_fullscreen(bool fullscreen);
 
+        // Monitor list cached from RandR, rebuilt only when the screen configuration changes
+        const std::vector<monitor>& get_monitors() const { return m_monitors; }
+        // Monitor containing the center of the window, nullptr if RandR is unavailable
+        const monitor* get_current_monitor() const;
+        // Refresh interval of the current monitor, zero if unknown
+        std::chrono::nanoseconds get_refresh_interval() const;
+
+        // WM_NORMAL_HINTS. A zero width or height leaves that dimension of the min or max size
+        // unconstrained, zeros for both remove the hint. The aspect ratio and resize increments
+        // are removed when either value is zero. Resize increments make the window manager only
+        // pick sizes that are multiples of the increment.
+        void set_min_size(uint32_t width, uint32_t height);
+        void set_max_size(uint32_t width, uint32_t height);
+        void set_aspect_ratio(uint32_t numerator, uint32_t denominator);
+        void set_resize_increment(uint32_t width, uint32_t height);
+
         void lock_cursor();
         void unlock_cursor();
         void hide_cursor();
@@ -25,16 +88,227 @@ namespace sw::detail {
 
         void set_cursor_pos(const int32_t x, const int32_t y, const bool screenspace);
 
+        // Text this window owns on the clipboard, otherwise the last text received by
+        // request_clipboard for windows without on_clipboard
         std::string get_clipboard() const;
-        void set_clipboard(const std::string& data);
+        // Takes ownership of the selection, the text is converted only when requested
+        void set_clipboard(const std::string& data,
+                           clipboard_selection selection = clipboard_selection::e_clipboard);
+        // Starts an asynchronous read delivered in chunks through
+        // on_clipboard(std::string_view chunk, bool finished). Returns false while another read
+        // is in progress.
+        bool request_clipboard(clipboard_selection selection = clipboard_selection::e_clipboard);
 
         std::string get_name() const;
         void set_name(const std::string& name);
 
+        // Thread-safe variants of the setters above, they are applied and flushed as one batch
+        // on the owning thread by its next poll
+        std::future<void> post_set_name(std::string name);
+        std::future<void> post_set_size(uint32_t width, uint32_t height);
+        std::future<void> post_set_fullscreen(bool fullscreen);
+        std::future<void> post_set_cursor_image(cursor_icon cursor);
+        std::future<void> post_set_cursor_pos(int32_t x, int32_t y, bool screenspace);
+
+        // Configure events are coalesced per poll and on_resize gets the final size only.
+        // A throttle interval delays on_resize further, on_resize_end fires once no configure
+        // event arrived for the end delay.
+        void set_resize_throttle(std::chrono::milliseconds interval);
+        void set_resize_end_delay(std::chrono::milliseconds delay);
+
+        // Milliseconds until a deferred resize notification is due or -1 if none is pending,
+        // loops blocking on the fd should wake up by then and dispatch
+        int get_dispatch_timeout() const;
+
+        // _NET_WM_SYNC_REQUEST, enabled for windows defining on_sync_request. After a sync
+        // request the window manager waits until a frame at the new size has been presented
+        // and acknowledged.
+        bool is_sync_request_pending() const { return m_sync_pending; }
+        void ack_sync_request();
+
+        // Hover positions of a drag are coalesced and on_drop_position is called at most once
+        // per interval
+        void set_drop_position_throttle(std::chrono::milliseconds interval);
+
+        // Number of events read from the connection that have not been dispatched yet
+        std::size_t get_backlog_size();
+
+        // Queues a copy of the 32 bytes of a core event behind the backlog, it is dispatched by
+        // the next poll as if the server had sent it
+        void inject_event(const xcb_generic_event_t& event);
+
+        // Late latching for renderers, call right before writing cursor or camera data into a
+        // frame. Takes what xcb already buffered plus at most one non-blocking socket read and
+        // updates the input snapshot below without dispatching, the events still reach the
+        // callbacks on the next poll.
+        void latch_input();
+
+        // Input snapshot, kept current by every poll and by latch_input
+        int32_t get_latched_mouse_x() const { return m_input.mouse_x; }
+        int32_t get_latched_mouse_y() const { return m_input.mouse_y; }
+        bool is_key_down(key_code key) const;
+        bool is_mouse_button_down(mouse_code button) const;
+
+        // Recent pointer samples oldest first, returns how many were written
+        std::size_t get_pointer_history(pointer_sample* samples, std::size_t capacity) const;
+
+        // Requests the server motion buffer for every span of new samples and merges it into
+        // the history, which fills in motion the server or client did not report
+        void set_motion_backfill(bool enable) { m_motion_backfill = enable; }
+
+        // Pointer position extrapolated to a point in time, e.g. the next vblank
+        pointer_sample predict_pointer(std::chrono::steady_clock::time_point when,
+                                       pointer_predictor predictor =
+                                           pointer_predictor::e_filtered) const;
+
+        // Estimated X server time of a steady clock time point
+        uint32_t to_server_time(std::chrono::steady_clock::time_point when) const;
+
+        // Makes poll_events and wait_events block while the window is not visible, so render
+        // loops stop spinning when minimized or covered
+        void set_block_while_hidden(bool block) { m_block_while_hidden = block; }
+
+        // Unmaps the window and drops owned selections and everything still in flight, the
+        // window reports closed until resume maps it again with a new name and size. The
+        // connection, the X window and its other properties are kept, see window_pool.
+        void suspend();
+        void resume(const char* name, uint32_t width, uint32_t height);
+
     private:
+        struct window_command {
+            enum class type : uint8_t { e_name, e_size, e_fullscreen, e_cursor_image, e_cursor_pos };
+
+            type command = type::e_name;
+            std::string name;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            int32_t x = 0;
+            int32_t y = 0;
+            bool flag = false;
+            cursor_icon cursor = cursor_icon::e_arrow;
+            std::promise<void> done;
+        };
+
+        std::future<void> post_command(window_command&& command);
+
+        void change_size(uint32_t width, uint32_t height);
+        void change_cursor_image(cursor_icon cursor);
+        void warp_cursor(int32_t x, int32_t y, bool screenspace);
+        void change_name(const std::string& name);
+        // Frees queued and backlogged events and abandons pending replies and transfers
+        void discard_events();
+
+        xcb_visualtype_t* find_visual(uint8_t depth) const;
+
+        bool create_sync_counter();
+
+        void init_randr();
+        void init_xkb();
+        void push_pointer_sample(int32_t x, int32_t y, uint32_t time);
+        void merge_motion_events(const xcb_get_motion_events_reply_t* reply);
+        void load_keymap();
+        void release_xkb();
+        void refresh_monitors();
+        bool query_hidden_state();
+
+        void update_size_hints(uint32_t flag, bool enable);
+
         inline xcb_intern_atom_reply_t* intern_atom_helper(bool only_if_exists, const char* str);
+        xcb_atom_t intern_atom(bool only_if_exists, const char* str);
+        // Sends every request before waiting for the first reply
+        void intern_atoms(const char* const* names, xcb_atom_t* atoms, std::size_t count);
+
+        xcb_atom_t selection_atom(clipboard_selection selection) const;
+        int selection_index(xcb_atom_t selection) const;
+        bool is_text_target(xcb_atom_t target) const;
+        bool send_selection_data(xcb_window_t requestor, xcb_atom_t property, xcb_atom_t target,
+                                 const std::shared_ptr<const std::string>& data);
+        std::size_t selection_chunk_size();
+        void request_selection_slice(int reader);
+        void send_drop_status(bool accept);
+        // Types beyond the three in the message are read from XdndTypeList asynchronously, the
+        // drop is accepted once poll_drop_types finds the uri list in the reply
+        bool drop_offers_uri_list(const xcb_client_message_event_t* enter_event);
+        void poll_drop_types();
 
     protected:
+        void apply_posted_commands();
+        // Frees queued and backlogged events only
+        void drop_queued_events();
+        // Reads the socket and frees the live events a replay stands in for. Close requests,
+        // errors and selection traffic are backlogged and still dispatched.
+        void drop_live_input();
+
+        void record_resize(uint32_t width, uint32_t height);
+        bool take_pending_resize();
+        bool take_resize_end();
+        bool is_resize_pending() const { return m_resize_pending; }
+
+        bool handle_sync_request(const xcb_generic_event_t* event);
+        bool take_sync_request();
+
+        // Returns true when the window moved
+        bool handle_configure_position(const xcb_generic_event_t* event);
+        void handle_reparent(const xcb_generic_event_t* event);
+        void handle_extension_event(const xcb_generic_event_t* event);
+        void update_monitors();
+        // Translates the window origin to root coordinates once per dispatch after a configure,
+        // m_x and m_y are relative to the frame for reparented windows
+        void update_root_offset();
+
+        // UTF-8 text produced by a key press including compose sequences, empty if there is
+        // none. The view points into a fixed buffer and stays valid until the next call.
+        std::string_view translate_key_text(const xcb_generic_event_t* event);
+        void handle_mapping_notify() { m_keymap_dirty = m_xkb_state != nullptr; }
+        void update_keymap();
+
+        // Selection reads are asynchronous, replies are polled once per dispatch. A chunk points
+        // into the reply it came from and stays valid until the next poll_selection call.
+        enum class selection_purpose : uint8_t { e_clipboard, e_drop };
+
+        struct selection_chunk {
+            std::string_view data;
+            selection_purpose purpose = selection_purpose::e_clipboard;
+            bool finished = false;
+            xcb_get_property_reply_t* reply = nullptr;
+        };
+
+        void handle_selection_notify(const xcb_generic_event_t* event);
+        void handle_selection_request(const xcb_generic_event_t* event);
+        void handle_selection_clear(const xcb_generic_event_t* event);
+        void handle_selection_property(const xcb_generic_event_t* event);
+        // Drops the outgoing transfers of a destroyed requestor, on its DestroyNotify or on the
+        // BadWindow error of a chunk written to it
+        void handle_selection_requestor_gone(const xcb_generic_event_t* event);
+        bool poll_selection(selection_chunk& chunk);
+        void store_clipboard_chunk(std::string_view data, bool finished);
+
+        // XDND target, the uri list of a drop is read through the selection reader
+        enum class drop_message : uint8_t { e_none, e_enter, e_position, e_leave, e_drop };
+
+        drop_message handle_drop_message(const xcb_generic_event_t* event);
+        bool take_drop_position(int32_t& x, int32_t& y);
+        void finish_drop(bool success);
+
+        // Returns true when is_visible changed
+        bool handle_visibility_event(const xcb_generic_event_t* event);
+
+        // Returns true once the last expose event of a sequence was added
+        bool accumulate_expose(const xcb_generic_event_t* event);
+        void clear_expose() { m_expose_count = 0; }
+
+        // Protocol name of the event type for traces, extension events are named by their
+        // extension only as far as xcb reports them generically
+        static const char* get_event_name(const xcb_generic_event_t* event);
+
+        // Core input, focus, configure, expose and visibility events. They are handled without
+        // requests to the server, everything else refers to windows, atoms or selections of
+        // the session it was recorded in.
+        static bool is_replayable(const xcb_generic_event_t* event);
+
+        // Made with sw::detached, there is no screen to issue requests against
+        bool is_detached() const { return m_screen == nullptr; }
+
         bool is_close_event(const xcb_generic_event_t* event) const;
         bool is_key_down_event(const xcb_generic_event_t* event,
                                const xcb_generic_event_t* prev) const;
@@ -44,10 +318,221 @@ namespace sw::detail {
         key_code keycode_to_enum(const uint8_t code) const;
         mouse_code mousecode_to_enum(const uint8_t code) const;
 
+        // Updates the input snapshot and the server time of the latest event carrying one.
+        // Applying events again in order ends in the same state, so events latched by
+        // latch_input are simply applied once more when dispatched. Pointer samples feed the
+        // history and the clock offset, they are only taken when the event is dispatched.
+        void update_input_state(const xcb_generic_event_t* event, bool take_samples = true);
+
+        void update_motion_history();
+
+    protected:
+        // Events read from the connection but not dispatched yet, dispatched first by the next
+        // dispatch. Filled by prepare_read and by polls that ran out of budget.
+        std::deque<xcb_generic_event_t*> m_backlog;
+        // Last event dispatched before a poll stopped early, auto repeat detection of the first
+        // backlog event compares against it
+        xcb_generic_event_t* m_backlog_prev = nullptr;
+
+        // Server time of the latest event carrying one
+        uint32_t m_event_time = 0;
+
+        bool m_block_while_hidden = false;
+
+        static constexpr std::size_t max_expose_rects = 16;
+        rect m_expose_rects[max_expose_rects];
+        std::size_t m_expose_count = 0;
+
     private:
         xcb_connection_t* m_connection;
         xcb_screen_t* m_screen;
         xcb_window_t m_window;
+        xcb_visualid_t m_visual_id;
+        xcb_colormap_t m_colormap = XCB_NONE;
+        uint8_t m_depth;
         xcb_intern_atom_reply_t* m_delete_window_atom;
+        xcb_intern_atom_reply_t* m_wake_atom;
+
+        mpsc_queue<window_command> m_commands;
+        std::atomic<bool> m_wake_pending{false};
+
+        std::chrono::steady_clock::duration m_resize_throttle{};
+        std::chrono::steady_clock::duration m_resize_end_delay = std::chrono::milliseconds(100);
+        std::chrono::steady_clock::time_point m_last_configure;
+        std::chrono::steady_clock::time_point m_last_resize_delivery;
+        uint32_t m_delivered_width;
+        uint32_t m_delivered_height;
+        bool m_resize_pending = false;
+        bool m_resize_active = false;
+
+        // ICCCM WM_SIZE_HINTS layout
+        struct size_hints {
+            uint32_t flags;
+            int32_t x, y;
+            int32_t width, height;
+            int32_t min_width, min_height;
+            int32_t max_width, max_height;
+            int32_t width_inc, height_inc;
+            int32_t min_aspect_num, min_aspect_den;
+            int32_t max_aspect_num, max_aspect_den;
+            int32_t base_width, base_height;
+            uint32_t win_gravity;
+        };
+        size_hints m_size_hints = {};
+
+        int32_t m_x = 10;
+        int32_t m_y = 10;
+        bool m_reparented = false;
+
+        int32_t m_root_x = 10;
+        int32_t m_root_y = 10;
+        bool m_root_offset_dirty = false;
+        bool m_root_offset_pending = false;
+        xcb_translate_coordinates_cookie_t m_root_offset_cookie = {};
+
+        std::vector<monitor> m_monitors;
+        uint8_t m_randr_first_event = 0;
+        bool m_randr_available = false;
+        bool m_monitors_dirty = false;
+
+        enum class selection_read_state : uint8_t { e_idle, e_converting, e_reading, e_incr };
+
+        struct selection_transfer {
+            xcb_window_t requestor;
+            xcb_atom_t property;
+            xcb_atom_t type;
+            std::shared_ptr<const std::string> data;
+            std::size_t offset;
+            // What this client selected on the requestor before the transfer, restored after the
+            // last transfer to it. Only one transfer per requestor owns the mask, it is queried
+            // asynchronously and its reply is in by the time the requestor deleted a chunk.
+            bool owns_mask;
+            bool mask_pending;
+            uint32_t requestor_mask;
+            xcb_get_window_attributes_cookie_t mask_cookie;
+        };
+
+        void end_selection_transfer(std::size_t index, bool requestor_alive);
+        void restore_requestor_mask(selection_transfer& transfer);
+
+        xcb_atom_t m_clipboard_atom;
+        xcb_atom_t m_utf8_atom;
+        xcb_atom_t m_text_atom;
+        xcb_atom_t m_mime_text_atom;
+        xcb_atom_t m_targets_atom;
+        xcb_atom_t m_incr_atom;
+        xcb_atom_t m_selection_property_atom;
+        xcb_atom_t m_drop_property_atom;
+
+        std::shared_ptr<const std::string> m_owned_selections[2];
+        std::vector<selection_transfer> m_selection_transfers;
+        std::size_t m_selection_chunk_size = 0;
+
+        // One reader per purpose so a drop does not have to wait for a clipboard read. Large
+        // properties are read in slices of selection_chunk_size.
+        struct selection_reader {
+            selection_read_state state = selection_read_state::e_idle;
+            xcb_atom_t property = XCB_NONE;
+            uint32_t offset = 0;
+            xcb_get_property_cookie_t cookie = {};
+            bool cookie_pending = false;
+            bool failed = false;
+            // Text of a selection this window owns, read without going through the server
+            std::shared_ptr<const std::string> local;
+        };
+        selection_reader m_selection_readers[2];
+        // Keeps the text of the last local read alive for the chunk pointing into it
+        std::shared_ptr<const std::string> m_local_chunk;
+
+        std::string m_clipboard_text;
+        std::string m_clipboard_pending;
+
+        enum xdnd_atom {
+            e_xdnd_aware,
+            e_xdnd_enter,
+            e_xdnd_position,
+            e_xdnd_status,
+            e_xdnd_leave,
+            e_xdnd_drop,
+            e_xdnd_finished,
+            e_xdnd_selection,
+            e_xdnd_type_list,
+            e_xdnd_action_copy,
+            e_xdnd_uri_list,
+            e_xdnd_atom_count
+        };
+        xcb_atom_t m_xdnd_atoms[e_xdnd_atom_count];
+
+        xcb_window_t m_drop_source = XCB_NONE;
+        uint32_t m_drop_version = 0;
+        bool m_drop_accepted = false;
+        bool m_drop_types_pending = false;
+        xcb_get_property_cookie_t m_drop_types_cookie = {};
+        bool m_drop_position_pending = false;
+        int32_t m_drop_x = 0;
+        int32_t m_drop_y = 0;
+        std::chrono::steady_clock::duration m_drop_position_throttle =
+            std::chrono::milliseconds(16);
+        std::chrono::steady_clock::time_point m_last_drop_position;
+
+        // Keysym and text per keycode, computed on first use and valid while the generation
+        // matches. Modifier and keymap changes bump the generation.
+        struct key_text {
+            uint32_t generation = 0;
+            uint32_t keysym = 0;
+            uint8_t length = 0;
+            char utf8[7] = {};
+        };
+
+        xkb_context* m_xkb_context = nullptr;
+        xkb_keymap* m_xkb_keymap = nullptr;
+        xkb_state* m_xkb_state = nullptr;
+        xkb_compose_table* m_compose_table = nullptr;
+        xkb_compose_state* m_compose_state = nullptr;
+        int32_t m_xkb_device_id = -1;
+        uint8_t m_xkb_first_event = 0;
+        bool m_keymap_dirty = false;
+        key_text m_key_text[256];
+        uint32_t m_key_text_generation = 1;
+        char m_compose_text[32] = {};
+
+        struct input_snapshot {
+            int32_t mouse_x = 0;
+            int32_t mouse_y = 0;
+            uint64_t keys[4] = {};
+            uint32_t buttons = 0;
+        };
+        input_snapshot m_input;
+
+        static constexpr std::size_t pointer_history_size = 64;
+        pointer_sample m_pointer_history[pointer_history_size];
+        std::size_t m_pointer_head = 0;
+        std::size_t m_pointer_count = 0;
+        std::vector<pointer_sample> m_pointer_merge;
+
+        bool m_motion_backfill = false;
+        bool m_motion_cookie_pending = false;
+        xcb_get_motion_events_cookie_t m_motion_cookie = {};
+        uint32_t m_backfill_start = 0;
+
+        // Smallest steady clock minus server time seen recently, the event with the least
+        // delivery delay gives the best estimate of the clock offset
+        int64_t m_server_clock_offset = INT64_MAX;
+        int64_t m_offset_window_min = INT64_MAX;
+        std::chrono::steady_clock::time_point m_offset_window_start;
+
+        xcb_atom_t m_wm_state_atom;
+        xcb_atom_t m_wm_state_hidden_atom;
+        xcb_atom_t m_wm_state_fullscreen_atom = XCB_NONE;
+        xcb_atom_t m_bypass_compositor_atom = XCB_NONE;
+        bool m_mapped = false;
+        bool m_obscured = false;
+        bool m_hidden = false;
+
+        xcb_sync_counter_t m_sync_counter = XCB_NONE;
+        xcb_atom_t m_sync_request_atom = XCB_NONE;
+        uint64_t m_sync_value = 0;
+        bool m_sync_pending = false;
+        bool m_sync_notify = false;
     };
 } // namespace sw::detail
\ No newline at end of file
@@ -1,43 +1,308 @@
 #pragma once
 #include "simple_window/window_xcb.hpp"
+#include "simple_window/action_map.hpp"
+#include "simple_window/event.hpp"
+#include "simple_window/input_log.hpp"
+#include "simple_window/trace.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <limits>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#    include <span>
+#endif
+
+#include <poll.h>
 
 namespace sw {
     template <typename Window>
     class window_interface : public detail::window_xcb {
     protected:
-        window_interface(const char* name, uint32_t width, uint32_t height)
-            : window_xcb(name, width, height) {}
+        window_interface(const char* name, uint32_t width, uint32_t height,
+                         window_visual visual = window_visual::e_opaque)
+            : window_xcb(name, width, height, visual, has_on_sync_request::value,
+                         has_on_drop::value, has_on_char::value) {}
+
+        window_interface(detached_t, uint32_t width, uint32_t height)
+            : window_xcb(detached, width, height) {}
 
         void poll_events() {
+            SW_TRACE_SCOPE("poll_events");
+            dispatch_events(&xcb_poll_for_event);
+            block_while_hidden();
+        }
+
+        // Dispatches like poll_events and additionally writes every translated event into the
+        // array, returns how many were written. Events that do not fit stay queued for the
+        // next call.
+        std::size_t poll_events(event* events, std::size_t capacity) {
+            m_event_batch = events;
+            m_event_batch_capacity = capacity;
+            m_event_batch_size = 0;
+            poll_events();
+            m_event_batch = nullptr;
+            return m_event_batch_size;
+        }
+
+#if defined(__cpp_lib_span)
+        std::span<event> poll_events(std::span<event> events) {
+            return events.first(poll_events(events.data(), events.size()));
+        }
+#endif
+
+        // Dispatches at most max_events events and stops once max_duration has passed, the
+        // rest stays queued in order for the next call. Close, focus and resize events already
+        // read are dispatched ahead of queued motion and exposes. Returns the number of events
+        // dispatched.
+        std::size_t poll_events(std::size_t max_events, std::chrono::nanoseconds max_duration) {
+            SW_TRACE_SCOPE("poll_events");
+            m_dispatch_deadline = std::chrono::steady_clock::now() + max_duration;
+            m_dispatch_limit = max_events;
+
+            read_backlog();
+            prioritize_backlog();
+            dispatch_events(&xcb_poll_for_queued_event);
+
+            m_dispatch_deadline = std::chrono::steady_clock::time_point::max();
+            m_dispatch_limit = std::numeric_limits<std::size_t>::max();
+            return m_dispatch_count;
+        }
+
+        // Key and mouse button input is run through the map and delivered to
+        // on_action(action_id, action_phase), the map must outlive the window or be reset
+        void set_action_map(action_map* map) { m_action_map = map; }
+
+        // Every dispatched event is written to the recorder until it is reset to nullptr
+        void record_input(input_recorder* recorder) { m_recorder = recorder; }
+
+        // Dispatches the recorded events that are due through the same path as live events,
+        // returns false once the log is finished. Only events is_replayable accepts are
+        // dispatched, so a detached window replays a log without a display. Live input is
+        // dropped meanwhile, close requests are still delivered.
+        bool replay_events(input_replayer& replayer) {
+            SW_TRACE_SCOPE("replay_events");
+            drop_live_input();
+            dispatch_events([&replayer](xcb_connection_t*) {
+                auto* event = replayer.next();
+                while (event != nullptr && !is_replayable(event)) {
+                    free(event);
+                    event = replayer.next();
+                }
+                return event;
+            });
+            return !replayer.is_finished();
+        }
+
+        // Blocks until events arrive or a deferred notification is due, then dispatches
+        void wait_events() {
+            SW_TRACE_SCOPE("wait_events");
+            wait_and_dispatch();
+            block_while_hidden();
+        }
+
+        // Reactor integration, lets the window share an epoll/io_uring loop with other fds:
+        //
+        //     while (!window.prepare_read()) window.dispatch_pending();
+        //     wait until window.get_fd() is readable or get_dispatch_timeout() expired
+        //     window.read_and_dispatch();
+
+        // Dispatches events already read from the connection without touching the socket
+        void dispatch_pending() { dispatch_events(&xcb_poll_for_queued_event); }
+
+        // Flushes pending requests, returns false if events are already queued in which case
+        // they must be dispatched before waiting on the fd
+        bool prepare_read() {
             auto connection = get_connection();
-            if (auto* curr = xcb_poll_for_event(connection); curr != nullptr) {
-                xcb_generic_event_t* prev = nullptr;
+            apply_posted_commands();
+            publish_state();
+            xcb_flush(connection);
+            if (m_backlog.empty()) {
+                if (auto* event = xcb_poll_for_queued_event(connection); event != nullptr) {
+                    m_backlog.push_back(event);
+                }
+            }
+            return m_backlog.empty();
+        }
+
+        // Reads the socket once without blocking and dispatches what that read returned. Unlike
+        // poll_events it does not go back to the socket while events keep arriving, so a flood
+        // on this connection cannot starve the other fds of the loop.
+        void read_and_dispatch() {
+            read_backlog();
+            dispatch_events(&xcb_poll_for_queued_event);
+        }
+
+    private:
+        void wait_and_dispatch() {
+            if (prepare_read()) {
+                SW_TRACE_SCOPE("wait");
+                pollfd fd = {get_fd(), POLLIN, 0};
+                ::poll(&fd, 1, get_dispatch_timeout());
+            }
+            dispatch_events(&xcb_poll_for_event);
+        }
 
-                auto* next = xcb_poll_for_event(connection);
-                while (next != nullptr) {
-                    process_event(next, curr, prev);
-                    free(prev);
-                    prev = curr;
-                    curr = next;
-                    next = xcb_poll_for_event(connection);
+        void block_while_hidden() {
+            while (m_block_while_hidden && is_open() && !is_visible() && !is_dispatch_exhausted()) {
+                wait_and_dispatch();
+            }
+        }
+
+        template <typename Fetch>
+        void dispatch_events(Fetch fetch) {
+            SW_TRACE_SCOPE("dispatch_events");
+            apply_posted_commands();
+
+            auto connection = get_connection();
+            auto fetch_next = [this, connection, fetch]() -> xcb_generic_event_t* {
+                if (!m_backlog.empty()) {
+                    auto* event = m_backlog.front();
+                    m_backlog.pop_front();
+                    return event;
+                }
+                return fetch(connection);
+            };
+
+            m_dispatch_count = 0;
+
+            xcb_generic_event_t* prev = std::exchange(m_backlog_prev, nullptr);
+            auto* curr = fetch_next();
+            auto* next = curr != nullptr ? fetch_next() : nullptr;
+            while (curr != nullptr) {
+                // Out of budget, the undispatched events go back to the front in order
+                if (is_dispatch_exhausted()) {
+                    if (next != nullptr) {
+                        m_backlog.push_front(next);
+                    }
+                    m_backlog.push_front(curr);
+                    m_backlog_prev = std::exchange(prev, nullptr);
+                    break;
+                }
+
+                if (m_recorder != nullptr) {
+                    m_recorder->record(curr);
                 }
                 process_event(next, curr, prev);
+                ++m_dispatch_count;
+
+                free(prev);
+                prev = curr;
+                curr = next;
+                next = curr != nullptr ? fetch_next() : nullptr;
+            }
+            free(prev);
+
+            update_monitors();
+            update_keymap();
+            update_motion_history();
+            update_root_offset();
+            deliver_resize();
+            deliver_drop_position();
+            deliver_selections();
+            publish_state();
+        }
+
+        void deliver_drop_position() {
+            int32_t x, y;
+            if (take_drop_position(x, y)) {
+                if constexpr (has_on_drop_position::value) {
+                    SW_TRACE_SCOPE("on_drop_position");
+                    static_cast<Window*>(this)->on_drop_position(x, y);
+                }
+            }
+        }
+
+        void deliver_selections() {
+            selection_chunk chunk;
+            while (poll_selection(chunk)) {
+                if (chunk.purpose == selection_purpose::e_drop) {
+                    // The uri list is streamed, a drop of many files never has to be buffered
+                    if constexpr (has_on_drop::value) {
+                        SW_TRACE_SCOPE("on_drop");
+                        static_cast<Window*>(this)->on_drop(chunk.data, chunk.finished);
+                    }
+                    if (chunk.finished) {
+                        finish_drop(chunk.reply != nullptr);
+                    }
+                }
+                else if constexpr (has_on_clipboard::value) {
+                    SW_TRACE_SCOPE("on_clipboard");
+                    static_cast<Window*>(this)->on_clipboard(chunk.data, chunk.finished);
+                }
+                else {
+                    store_clipboard_chunk(chunk.data, chunk.finished);
+                }
+            }
+        }
+
+        // The coalesced resize ignores the budget, only a batch without room defers it
+        void deliver_resize() {
+            if (has_batch_room() && take_pending_resize()) {
+                request_redraw();
+                if constexpr (has_on_resize::value) {
+                    SW_TRACE_SCOPE("on_resize");
+                    static_cast<Window*>(this)->on_resize(m_width, m_height);
+                }
+                emit_event({event_type::e_resize, key_code::e_NONE, mouse_code::e_NONE,
+                            static_cast<int32_t>(m_width), static_cast<int32_t>(m_height)});
+            }
+
+            if (has_batch_room() && take_resize_end()) {
+                if constexpr (has_on_resize_end::value) {
+                    SW_TRACE_SCOPE("on_resize_end");
+                    static_cast<Window*>(this)->on_resize_end(m_width, m_height);
+                }
+                emit_event({event_type::e_resize_end, key_code::e_NONE, mouse_code::e_NONE,
+                            static_cast<int32_t>(m_width), static_cast<int32_t>(m_height)});
+            }
+
+            if constexpr (has_on_sync_request::value) {
+                if (take_sync_request()) {
+                    SW_TRACE_SCOPE("on_sync_request");
+                    static_cast<Window*>(this)->on_sync_request();
+                }
             }
         }
 
-    private:
         void process_event(const xcb_generic_event_t* next, const xcb_generic_event_t* curr,
                            const xcb_generic_event_t* prev) {
+            SW_TRACE_SCOPE_ARG("process_event", get_event_name(curr));
+            update_input_state(curr);
+
             switch (curr->response_type & ~0x80) {
                 // Destroy event
                 case XCB_CLIENT_MESSAGE: {
                     if (is_close_event(curr)) {
                         set_open_flag_false();
                         if constexpr (has_on_close::value) {
+                            SW_TRACE_SCOPE("on_close");
                             static_cast<Window*>(this)->on_close();
                         }
+                        emit_event({event_type::e_close});
+                    }
+                    else if (auto message = handle_drop_message(curr);
+                             message != drop_message::e_none) {
+                        // Positions are delivered rate limited by deliver_drop_position
+                        if (message == drop_message::e_enter) {
+                            if constexpr (has_on_drop_enter::value) {
+                                SW_TRACE_SCOPE("on_drop_enter");
+                                static_cast<Window*>(this)->on_drop_enter();
+                            }
+                        }
+                        else if (message == drop_message::e_leave) {
+                            if constexpr (has_on_drop_leave::value) {
+                                SW_TRACE_SCOPE("on_drop_leave");
+                                static_cast<Window*>(this)->on_drop_leave();
+                            }
+                        }
+                    }
+                    else if constexpr (has_on_sync_request::value) {
+                        // Delivered after the matching on_resize by deliver_resize
+                        handle_sync_request(curr);
                     }
                     break;
                 }
@@ -46,50 +311,148 @@ namespace sw {
                 case XCB_CONFIGURE_NOTIFY: {
                     auto config_event = reinterpret_cast<const xcb_configure_notify_event_t*>(curr);
                     if (config_event->width != m_width || config_event->height != m_height) {
-                        m_width = config_event->width;
-                        m_height = config_event->height;
-                        if constexpr (has_on_resize::value) {
-                            static_cast<Window*>(this)->on_resize(m_width, m_height);
+                        // Delivered once per poll by deliver_resize
+                        record_resize(config_event->width, config_event->height);
+                    }
+
+                    if (handle_configure_position(curr)) {
+                        if constexpr (has_on_move::value) {
+                            SW_TRACE_SCOPE("on_move");
+                            static_cast<Window*>(this)->on_move(get_x(), get_y());
                         }
                     }
                     break;
                 }
 
+                case XCB_REPARENT_NOTIFY: {
+                    handle_reparent(curr);
+                    break;
+                }
+
+                // Errors of unchecked requests
+                case 0:
+                case XCB_DESTROY_NOTIFY: {
+                    handle_selection_requestor_gone(curr);
+                    break;
+                }
+
+                // Visibility
+                case XCB_MAP_NOTIFY:
+                case XCB_UNMAP_NOTIFY:
+                case XCB_VISIBILITY_NOTIFY:
+                case XCB_PROPERTY_NOTIFY: {
+                    handle_selection_property(curr);
+                    if (handle_visibility_event(curr)) {
+                        if constexpr (has_on_visibility_change::value) {
+                            SW_TRACE_SCOPE("on_visibility_change");
+                            static_cast<Window*>(this)->on_visibility_change(is_visible());
+                        }
+                    }
+                    break;
+                }
+
+                case XCB_MAPPING_NOTIFY: {
+                    handle_mapping_notify();
+                    break;
+                }
+
+                // Clipboard
+                case XCB_SELECTION_NOTIFY: {
+                    handle_selection_notify(curr);
+                    break;
+                }
+                case XCB_SELECTION_REQUEST: {
+                    handle_selection_request(curr);
+                    break;
+                }
+                case XCB_SELECTION_CLEAR: {
+                    handle_selection_clear(curr);
+                    break;
+                }
+
+                case XCB_EXPOSE: {
+                    if (accumulate_expose(curr)) {
+                        request_redraw();
+                        if constexpr (has_on_expose::value) {
+                            SW_TRACE_SCOPE("on_expose");
+                            static_cast<Window*>(this)->on_expose(
+                                static_cast<const rect*>(m_expose_rects), m_expose_count);
+                        }
+                        clear_expose();
+                    }
+                    break;
+                }
+
                 // Focus
                 case XCB_FOCUS_IN: {
                     if constexpr (has_on_focus_in::value) {
+                        SW_TRACE_SCOPE("on_focus_in");
                         static_cast<Window*>(this)->on_focus_in();
                     }
+                    emit_event({event_type::e_focus_in});
                     break;
                 }
 
                 case XCB_FOCUS_OUT: {
-                    if constexpr (has_on_focus_out::value) {
-                        if (is_open()) {
+                    if constexpr (has_on_action::value) {
+                        if (m_action_map != nullptr) {
+                            m_action_map->release_all(action_callback());
+                        }
+                    }
+                    if (is_open()) {
+                        if constexpr (has_on_focus_out::value) {
+                            SW_TRACE_SCOPE("on_focus_out");
                             static_cast<Window*>(this)->on_focus_out();
                         }
+                        emit_event({event_type::e_focus_out});
                     }
                     break;
                 }
 
                 // Keyboard
                 case XCB_KEY_PRESS: {
-                    if constexpr (has_on_key_down::value) {
+                    if (has_on_key_down::value || has_on_action::value || is_translating()) {
                         if (is_key_down_event(curr, prev)) {
                             auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(curr);
-                            static_cast<Window*>(this)->on_key_down(
-                                keycode_to_enum(key_event->detail));
+                            const auto code = keycode_to_enum(key_event->detail);
+                            if constexpr (has_on_action::value) {
+                                if (m_action_map != nullptr) {
+                                    m_action_map->press(code, action_callback());
+                                }
+                            }
+                            if constexpr (has_on_key_down::value) {
+                                SW_TRACE_SCOPE("on_key_down");
+                                static_cast<Window*>(this)->on_key_down(code);
+                            }
+                            emit_event({event_type::e_key_down, code});
+                        }
+                    }
+                    // After on_key_down like WM_CHAR follows WM_KEYDOWN on Win32, auto repeated
+                    // presses produce text too
+                    if constexpr (has_on_char::value) {
+                        if (auto text = translate_key_text(curr); !text.empty()) {
+                            SW_TRACE_SCOPE("on_char");
+                            static_cast<Window*>(this)->on_char(text);
                         }
                     }
                     break;
                 }
 
                 case XCB_KEY_RELEASE: {
-                    if constexpr (has_on_key_up::value) {
+                    if (has_on_key_up::value || has_on_action::value || is_translating()) {
                         if (is_key_up_event(curr, next)) {
                             auto key_event = reinterpret_cast<const xcb_key_release_event_t*>(curr);
-                            static_cast<Window*>(this)->on_key_up(
-                                keycode_to_enum(key_event->detail));
+                            const auto code = keycode_to_enum(key_event->detail);
+                            if constexpr (has_on_action::value) {
+                                if (m_action_map != nullptr) {
+                                    m_action_map->release(code, action_callback());
+                                }
+                            }
+                            if constexpr (has_on_key_up::value) {
+                                SW_TRACE_SCOPE("on_key_up");
+                                static_cast<Window*>(this)->on_key_up(code);
+                            }
+                            emit_event({event_type::e_key_up, code});
                         }
                     }
                     break;
@@ -101,34 +464,54 @@ namespace sw {
                     switch (button_event->detail) {
                         case 4: {
                             if constexpr (has_on_mouse_scroll_v::value) {
+                                SW_TRACE_SCOPE("on_mouse_scroll_v");
                                 static_cast<Window*>(this)->on_mouse_scroll_v(1);
                             }
+                            emit_event({event_type::e_mouse_scroll_v, key_code::e_NONE,
+                                        mouse_code::e_NONE, 1});
                             break;
                         }
                         case 5: {
                             if constexpr (has_on_mouse_scroll_v::value) {
+                                SW_TRACE_SCOPE("on_mouse_scroll_v");
                                 static_cast<Window*>(this)->on_mouse_scroll_v(-1);
                             }
+                            emit_event({event_type::e_mouse_scroll_v, key_code::e_NONE,
+                                        mouse_code::e_NONE, -1});
                             break;
                         }
                         case 6: {
                             if constexpr (has_on_mouse_scroll_h::value) {
+                                SW_TRACE_SCOPE("on_mouse_scroll_h");
                                 static_cast<Window*>(this)->on_mouse_scroll_h(1);
                             }
+                            emit_event({event_type::e_mouse_scroll_h, key_code::e_NONE,
+                                        mouse_code::e_NONE, 1});
                             break;
                         }
                         case 7: {
                             if constexpr (has_on_mouse_scroll_h::value) {
+                                SW_TRACE_SCOPE("on_mouse_scroll_h");
                                 static_cast<Window*>(this)->on_mouse_scroll_h(-1);
                             }
+                            emit_event({event_type::e_mouse_scroll_h, key_code::e_NONE,
+                                        mouse_code::e_NONE, -1});
                             break;
                         }
                         default: {
+                            const auto code = mousecode_to_enum(button_event->detail);
+                            if constexpr (has_on_action::value) {
+                                if (m_action_map != nullptr) {
+                                    m_action_map->press(code, action_callback());
+                                }
+                            }
                             if constexpr (has_on_mouse_button_down::value) {
+                                SW_TRACE_SCOPE("on_mouse_button_down");
                                 static_cast<Window*>(this)->on_mouse_button_down(
-                                    mousecode_to_enum(button_event->detail), button_event->event_x,
-                                    button_event->event_y);
+                                    code, button_event->event_x, button_event->event_y);
                             }
+                            emit_event({event_type::e_mouse_button_down, key_code::e_NONE, code,
+                                        button_event->event_x, button_event->event_y});
                             break;
                         }
                     }
@@ -136,15 +519,25 @@ namespace sw {
                 }
 
                 case XCB_BUTTON_RELEASE: {
-                    if constexpr (has_on_mouse_button_up::value) {
+                    if (has_on_mouse_button_up::value || has_on_action::value || is_translating()) {
                         auto button_event =
                             reinterpret_cast<const xcb_button_release_event_t*>(curr);
 
                         // Check if scroll events
                         if (button_event->detail != 4 && button_event->detail != 5) {
-                            static_cast<Window*>(this)->on_mouse_button_up(
-                                mousecode_to_enum(button_event->detail), button_event->event_x,
-                                button_event->event_y);
+                            const auto code = mousecode_to_enum(button_event->detail);
+                            if constexpr (has_on_action::value) {
+                                if (m_action_map != nullptr) {
+                                    m_action_map->release(code, action_callback());
+                                }
+                            }
+                            if constexpr (has_on_mouse_button_up::value) {
+                                SW_TRACE_SCOPE("on_mouse_button_up");
+                                static_cast<Window*>(this)->on_mouse_button_up(
+                                    code, button_event->event_x, button_event->event_y);
+                            }
+                            emit_event({event_type::e_mouse_button_up, key_code::e_NONE, code,
+                                        button_event->event_x, button_event->event_y});
                         }
                     }
                     break;
@@ -163,17 +556,150 @@ namespace sw {
                     handle_mouse_move(static_cast<int32_t>(motion_event->event_x), static_cast<int32_t>(motion_event->event_y));
 
                     if constexpr (has_on_mouse_move_pos::value) {
+                        SW_TRACE_SCOPE("on_mouse_move_pos");
                         static_cast<Window*>(this)->on_mouse_move_pos(m_mouse_x, m_mouse_y);
                     }
 
                     if constexpr (has_on_mouse_move_delta::value) {
+                        SW_TRACE_SCOPE("on_mouse_move_delta");
                         static_cast<Window*>(this)->on_mouse_move_delta(m_mouse_x - m_last_cursor_x, m_mouse_y - m_last_cursor_y);
                     }
+
+                    emit_event({event_type::e_mouse_move, key_code::e_NONE, mouse_code::e_NONE,
+                                m_mouse_x, m_mouse_y});
                     break;
                 }
+
+                default: {
+                    handle_extension_event(curr);
+                    break;
+                }
+            }
+        }
+
+        inline void emit_event(event e) {
+            e.time = m_event_time;
+            if (m_event_batch != nullptr) {
+                m_event_batch[m_event_batch_size++] = e;
+            }
+            if constexpr (has_on_event::value) {
+                SW_TRACE_SCOPE("on_event");
+                static_cast<Window*>(this)->on_event(e);
+            }
+            // coroutine_window resumes its awaiting tasks here, independent of on_event
+            if constexpr (has_resume_waiters::value) {
+                static_cast<Window*>(this)->resume_waiters(e);
+            }
+        }
+
+        inline auto action_callback() {
+            return [this](const action_id action, const action_phase phase) {
+                SW_TRACE_SCOPE("on_action");
+                static_cast<Window*>(this)->on_action(action, phase);
+            };
+        }
+
+        // Whether sw::event values are consumed, otherwise translating them is skipped
+        inline bool is_translating() const {
+            return has_on_event::value || has_resume_waiters::value || m_event_batch != nullptr;
+        }
+
+        // Every event translates to at most one batch entry, so a batch with one free slot
+        // can take the next event
+        inline bool is_dispatch_exhausted() const {
+            // A pending resize keeps one slot free so a flood of other events cannot push it
+            // out of every batch
+            const std::size_t reserved = is_resize_pending() ? 1 : 0;
+            if (m_event_batch != nullptr &&
+                m_event_batch_size + reserved >= m_event_batch_capacity) {
+                return true;
+            }
+            if (m_dispatch_count >= m_dispatch_limit) {
+                return true;
+            }
+            return m_dispatch_deadline != std::chrono::steady_clock::time_point::max() &&
+                   std::chrono::steady_clock::now() >= m_dispatch_deadline;
+        }
+
+        inline bool has_batch_room() const {
+            return m_event_batch == nullptr || m_event_batch_size < m_event_batch_capacity;
+        }
+
+        // Moves everything a single socket read returns into the backlog
+        void read_backlog() {
+            auto connection = get_connection();
+            if (auto* event = xcb_poll_for_event(connection); event != nullptr) {
+                m_backlog.push_back(event);
+                while ((event = xcb_poll_for_queued_event(connection)) != nullptr) {
+                    m_backlog.push_back(event);
+                }
             }
         }
 
+        // Close, focus and resize events overtake the motion and expose events queued before
+        // them but never key or button input, so autorepeat pairs stay adjacent and a focus
+        // loss still releases after the releases that came first
+        void prioritize_backlog() {
+            auto insert_at = m_backlog.begin();
+            for (auto it = m_backlog.begin(); it != m_backlog.end(); ++it) {
+                switch ((*it)->response_type & ~0x80) {
+                    case XCB_CLIENT_MESSAGE:
+                    case XCB_CONFIGURE_NOTIFY:
+                    case XCB_FOCUS_IN:
+                    case XCB_FOCUS_OUT: {
+                        std::rotate(insert_at, it, std::next(it));
+                        ++insert_at;
+                        break;
+                    }
+                    case XCB_MOTION_NOTIFY:
+                    case XCB_EXPOSE: break;
+                    default: insert_at = std::next(it); break;
+                }
+            }
+        }
+
+    private:
+        event* m_event_batch = nullptr;
+        std::size_t m_event_batch_capacity = 0;
+        std::size_t m_event_batch_size = 0;
+
+        action_map* m_action_map = nullptr;
+        input_recorder* m_recorder = nullptr;
+
+        std::size_t m_dispatch_count = 0;
+        std::size_t m_dispatch_limit = std::numeric_limits<std::size_t>::max();
+        std::chrono::steady_clock::time_point m_dispatch_deadline =
+            std::chrono::steady_clock::time_point::max();
+
+
+        class has_on_event {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_event));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_resume_waiters {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::resume_waiters));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
         class has_on_resize {
         private:
             typedef char YesType[1];
@@ -188,6 +714,146 @@ namespace sw {
             enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
         };
 
+        class has_on_resize_end {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_resize_end));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_sync_request {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_sync_request));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_expose {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_expose));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_visibility_change {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_visibility_change));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_clipboard {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_clipboard));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_drop_enter {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_drop_enter));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_drop_position {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_drop_position));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_drop_leave {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_drop_leave));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_drop {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_drop));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
+        class has_on_action {
+        private:
+            typedef char YesType[1];
+            typedef char NoType[2];
+
+            template <typename C>
+            static YesType& test(decltype(&C::on_action));
+            template <typename C>
+            static NoType& test(...);
+
+        public:
+            enum { value = sizeof(test<Window>(0)) == sizeof(YesType) };
+        };
+
         class has_on_move {
         private:
             typedef char YesType[1];
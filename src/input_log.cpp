@@ -0,0 +1,268 @@
+#include "simple_window/input_log.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sw {
+    namespace {
+        constexpr uint8_t log_magic[4] = {'S', 'W', 'I', 'L'};
+        constexpr uint32_t log_version = 1;
+        // Magic, version and the size of the complete records, kept up to date after every
+        // record so a log of a process that crashed is still read up to its last event
+        constexpr std::size_t header_size = 16;
+        constexpr std::size_t grow_size = std::size_t(1) << 20;
+
+        // Core events are 32 bytes, xcb appends full_sequence and moves the extra data of
+        // generic events behind it
+        constexpr std::size_t event_size = 32;
+        constexpr std::size_t allocation_size = sizeof(xcb_generic_event_t);
+
+        inline uint32_t generic_extra_size(const uint8_t* event) {
+            if ((event[0] & ~0x80) != XCB_GE_GENERIC) {
+                return 0;
+            }
+            uint32_t length;
+            std::memcpy(&length, event + 4, sizeof(length));
+            return length * 4;
+        }
+    } // namespace
+
+    input_recorder::input_recorder(const char* path)
+        : m_fd(::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)),
+          m_last_time(std::chrono::steady_clock::now()) {
+        if (m_fd < 0) {
+            throw std::runtime_error("simple_window: Failed to create input log");
+        }
+
+        auto* header = reserve(header_size);
+        std::memcpy(header, log_magic, sizeof(log_magic));
+        std::memcpy(header + 4, &log_version, sizeof(log_version));
+        m_size = header_size;
+        commit();
+    }
+
+    input_recorder::~input_recorder() { close(); }
+
+    void input_recorder::record(const xcb_generic_event_t* event) {
+        if (m_fd < 0) {
+            return;
+        }
+
+        using namespace std::chrono;
+        const auto now = steady_clock::now();
+        put_varint(static_cast<uint64_t>(duration_cast<microseconds>(now - m_last_time).count()));
+        m_last_time = now;
+
+        const auto* bytes = reinterpret_cast<const uint8_t*>(event);
+        auto* previous = m_previous[bytes[0] & ~0x80];
+
+        // Bit i - 1 of the mask is set when byte i differs from the previous event of the type
+        uint8_t changed[event_size];
+        uint32_t mask = 0;
+        uint32_t changed_count = 0;
+        for (std::size_t i = 1; i < event_size; ++i) {
+            const auto diff = static_cast<uint8_t>(bytes[i] ^ previous[i]);
+            if (diff != 0) {
+                mask |= 1u << (i - 1);
+                changed[changed_count++] = diff;
+            }
+        }
+        std::memcpy(previous, bytes, event_size);
+
+        *reserve(1) = bytes[0];
+        ++m_size;
+        put_varint(mask);
+        std::memcpy(reserve(changed_count), changed, changed_count);
+        m_size += changed_count;
+
+        if (const auto extra = generic_extra_size(bytes); extra > 0) {
+            std::memcpy(reserve(extra), bytes + allocation_size, extra);
+            m_size += extra;
+        }
+
+        ++m_event_count;
+        commit();
+    }
+
+    void input_recorder::close() {
+        if (m_fd < 0) {
+            return;
+        }
+
+        ::munmap(m_data, m_capacity);
+        if (::ftruncate(m_fd, static_cast<off_t>(m_size)) != 0) {
+            m_size = m_capacity;
+        }
+        ::close(m_fd);
+
+        m_fd = -1;
+        m_data = nullptr;
+        m_capacity = 0;
+    }
+
+    void input_recorder::commit() {
+        const uint64_t size = m_size;
+        std::memcpy(m_data + 8, &size, sizeof(size));
+    }
+
+    uint8_t* input_recorder::reserve(const std::size_t size) {
+        if (m_size + size > m_capacity) {
+            const auto capacity = m_capacity + std::max(grow_size, size);
+            if (::ftruncate(m_fd, static_cast<off_t>(capacity)) != 0) {
+                throw std::runtime_error("simple_window: Failed to grow input log");
+            }
+
+            constexpr int protection = PROT_READ | PROT_WRITE;
+            auto* data = m_data == nullptr
+                             ? ::mmap(nullptr, capacity, protection, MAP_SHARED, m_fd, 0)
+                             : ::mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+            if (data == MAP_FAILED) {
+                throw std::runtime_error("simple_window: Failed to map input log");
+            }
+
+            m_data = static_cast<uint8_t*>(data);
+            m_capacity = capacity;
+        }
+        return m_data + m_size;
+    }
+
+    void input_recorder::put_varint(uint64_t value) {
+        auto* out = reserve(10);
+        while (value >= 0x80) {
+            *out++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<uint8_t>(value);
+        m_size = static_cast<std::size_t>(out - m_data);
+    }
+
+    input_replayer::input_replayer(const char* path, const replay_pacing pacing)
+        : m_pacing(pacing) {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("simple_window: Failed to open input log");
+        }
+
+        struct stat info = {};
+        if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= header_size) {
+            m_size = static_cast<std::size_t>(info.st_size);
+            auto* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            m_data = data != MAP_FAILED ? static_cast<uint8_t*>(data) : nullptr;
+        }
+        ::close(fd);
+
+        uint32_t version = 0;
+        uint64_t size = 0;
+        if (m_data != nullptr) {
+            std::memcpy(&version, m_data + 4, sizeof(version));
+            std::memcpy(&size, m_data + 8, sizeof(size));
+        }
+        if (m_data == nullptr || std::memcmp(m_data, log_magic, sizeof(log_magic)) != 0 ||
+            version != log_version || size < header_size || size > m_size) {
+            if (m_data != nullptr) {
+                ::munmap(m_data, m_size);
+            }
+            throw std::runtime_error("simple_window: Invalid input log");
+        }
+
+        ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+        m_mapped_size = m_size;
+        m_size = static_cast<std::size_t>(size);
+        rewind();
+    }
+
+    input_replayer::~input_replayer() { ::munmap(m_data, m_mapped_size); }
+
+    void input_replayer::rewind() {
+        m_offset = header_size;
+        m_start = std::chrono::steady_clock::now();
+        m_elapsed = std::chrono::microseconds(0);
+        std::memset(m_previous, 0, sizeof(m_previous));
+    }
+
+    std::chrono::steady_clock::time_point input_replayer::get_next_time() {
+        const auto record = m_offset;
+
+        uint64_t delta;
+        if (m_pacing != replay_pacing::e_realtime || !get_varint(delta)) {
+            return std::chrono::steady_clock::time_point::min();
+        }
+
+        m_offset = record;
+        return m_start + m_elapsed + std::chrono::microseconds(delta);
+    }
+
+    xcb_generic_event_t* input_replayer::next() {
+        const auto record = m_offset;
+
+        uint64_t delta;
+        if (!get_varint(delta)) {
+            return nullptr;
+        }
+
+        const auto elapsed = m_elapsed + std::chrono::microseconds(delta);
+        if (m_pacing == replay_pacing::e_realtime &&
+            std::chrono::steady_clock::now() < m_start + elapsed) {
+            m_offset = record;
+            return nullptr;
+        }
+
+        uint64_t mask;
+        if (m_offset >= m_size) {
+            m_offset = m_size;
+            return nullptr;
+        }
+        const uint8_t response_type = m_data[m_offset++];
+        if (!get_varint(mask)) {
+            return nullptr;
+        }
+
+        auto* previous = m_previous[response_type & ~0x80];
+        previous[0] = response_type;
+        for (std::size_t i = 1; i < event_size; ++i) {
+            if (mask & (uint64_t(1) << (i - 1))) {
+                if (m_offset >= m_size) {
+                    m_offset = m_size;
+                    return nullptr;
+                }
+                previous[i] ^= m_data[m_offset++];
+            }
+        }
+
+        const auto extra = generic_extra_size(previous);
+        if (extra > m_size - m_offset) {
+            m_offset = m_size;
+            return nullptr;
+        }
+
+        auto* event = static_cast<xcb_generic_event_t*>(std::malloc(allocation_size + extra));
+        std::memcpy(event, previous, event_size);
+        event->full_sequence = event->sequence;
+        std::memcpy(reinterpret_cast<uint8_t*>(event) + allocation_size, m_data + m_offset, extra);
+        m_offset += extra;
+
+        m_elapsed = elapsed;
+        return event;
+    }
+
+    bool input_replayer::get_varint(uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && m_offset < m_size; shift += 7) {
+            const auto byte = m_data[m_offset++];
+            value |= uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+
+        m_offset = m_size;
+        return false;
+    }
+} // namespace sw
\ No newline at end of file
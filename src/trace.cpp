@@ -0,0 +1,388 @@
+#include "simple_window/trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#    include <windows.h>
+#else
+#    include <sys/syscall.h>
+#    include <time.h>
+#    include <unistd.h>
+#endif
+
+namespace sw::trace::detail {
+    namespace {
+        struct trace_record {
+            uint64_t time;
+            const char* name;
+            const char* detail;
+            phase ph;
+        };
+
+        // Written only by its thread. A buffer whose epoch is behind the global one belongs to
+        // an earlier trace, its thread resets it on the next append and flushes skip it.
+        struct thread_buffer {
+            std::unique_ptr<trace_record[]> records;
+            std::size_t capacity = 0;
+            std::atomic<std::size_t> size{0};
+            std::atomic<std::size_t> dropped{0};
+            std::atomic<uint32_t> epoch{0};
+            uint32_t tid = 0;
+            std::string name;
+        };
+
+        // Buffers outlive their threads so events of finished threads are still written
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<thread_buffer>> buffers;
+            std::atomic<uint32_t> epoch{0};
+            std::atomic<std::size_t> capacity{0};
+        };
+
+        registry& get_registry() {
+            static registry instance;
+            return instance;
+        }
+
+        thread_local thread_buffer* t_buffer = nullptr;
+
+        uint32_t current_pid() {
+#if defined(_WIN32)
+            return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+            return static_cast<uint32_t>(getpid());
+#endif
+        }
+
+        uint32_t current_tid() {
+#if defined(_WIN32)
+            return static_cast<uint32_t>(GetCurrentThreadId());
+#elif defined(SYS_gettid)
+            return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+            return static_cast<uint32_t>(getpid());
+#endif
+        }
+
+        uint64_t now_ns() {
+            using namespace std::chrono;
+            return static_cast<uint64_t>(
+                duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+        }
+
+        thread_buffer* register_thread() {
+            auto buffer = std::make_unique<thread_buffer>();
+            buffer->tid = current_tid();
+
+            auto& r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.buffers.push_back(std::move(buffer));
+            return r.buffers.back().get();
+        }
+
+        thread_buffer& local_buffer() {
+            if (t_buffer == nullptr) {
+                t_buffer = register_thread();
+            }
+            return *t_buffer;
+        }
+    } // namespace
+
+    void append(const phase ph, const char* name, const char* detail) {
+        auto& r = get_registry();
+        auto& buffer = local_buffer();
+
+        const uint32_t epoch = r.epoch.load(std::memory_order_acquire);
+        if (buffer.epoch.load(std::memory_order_relaxed) != epoch) {
+            const std::size_t capacity = r.capacity.load(std::memory_order_relaxed);
+            if (buffer.capacity != capacity) {
+                buffer.records = std::make_unique<trace_record[]>(capacity);
+                buffer.capacity = capacity;
+            }
+            buffer.size.store(0, std::memory_order_relaxed);
+            buffer.dropped.store(0, std::memory_order_relaxed);
+            buffer.epoch.store(epoch, std::memory_order_release);
+        }
+
+        const std::size_t size = buffer.size.load(std::memory_order_relaxed);
+        if (size == buffer.capacity) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.records[size] = {now_ns(), name, detail, ph};
+        buffer.size.store(size + 1, std::memory_order_release);
+    }
+
+    namespace {
+        // Calls write(buffer, count) for every buffer of the current trace with the number of
+        // records published when the flush started. start waits for the lock, so the epoch
+        // holds still and no buffer of this trace is reset while it is written.
+        template <typename Write>
+        void for_each_buffer(Write&& write) {
+            auto& r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            const uint32_t epoch = r.epoch.load(std::memory_order_relaxed);
+
+            for (const auto& buffer : r.buffers) {
+                if (buffer->epoch.load(std::memory_order_acquire) != epoch) {
+                    continue;
+                }
+                write(*buffer, buffer->size.load(std::memory_order_acquire));
+            }
+        }
+
+        void write_json_string(std::FILE* file, const char* text) {
+            std::fputc('"', file);
+            for (const char* c = text; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    std::fputc('\\', file);
+                }
+                if (static_cast<unsigned char>(*c) >= 0x20) {
+                    std::fputc(*c, file);
+                }
+            }
+            std::fputc('"', file);
+        }
+
+        // Protobuf wire format, just what a Perfetto trace of track events needs
+        class proto_writer {
+        public:
+            void varint(uint32_t field, uint64_t value) {
+                key(field, 0);
+                put_varint(value);
+            }
+
+            void string(uint32_t field, const std::string& value) {
+                key(field, 2);
+                put_varint(value.size());
+                m_data.insert(m_data.end(), value.begin(), value.end());
+            }
+
+            void message(uint32_t field, const proto_writer& nested) {
+                key(field, 2);
+                put_varint(nested.m_data.size());
+                m_data.insert(m_data.end(), nested.m_data.begin(), nested.m_data.end());
+            }
+
+            const std::vector<char>& data() const { return m_data; }
+            void clear() { m_data.clear(); }
+
+        private:
+            void key(uint32_t field, uint32_t wire_type) { put_varint(field << 3 | wire_type); }
+
+            void put_varint(uint64_t value) {
+                while (value >= 0x80) {
+                    m_data.push_back(static_cast<char>(value | 0x80));
+                    value >>= 7;
+                }
+                m_data.push_back(static_cast<char>(value));
+            }
+
+            std::vector<char> m_data;
+        };
+
+        // Field numbers from perfetto/trace/trace_packet.proto and track_event.proto
+        namespace pf {
+            constexpr uint32_t trace_packet = 1;
+
+            constexpr uint32_t packet_clock_snapshot = 6;
+            constexpr uint32_t packet_timestamp = 8;
+            constexpr uint32_t packet_sequence_id = 10;
+            constexpr uint32_t packet_track_event = 11;
+            constexpr uint32_t packet_clock_id = 58;
+            constexpr uint32_t packet_track_descriptor = 60;
+
+            constexpr uint32_t snapshot_clock = 1;
+            constexpr uint32_t clock_id = 1;
+            constexpr uint32_t clock_timestamp = 2;
+
+            constexpr uint32_t descriptor_uuid = 1;
+            constexpr uint32_t descriptor_thread = 4;
+            constexpr uint32_t thread_pid = 1;
+            constexpr uint32_t thread_tid = 2;
+            constexpr uint32_t thread_name = 5;
+
+            constexpr uint32_t event_debug_annotation = 4;
+            constexpr uint32_t event_type = 9;
+            constexpr uint32_t event_track_uuid = 11;
+            constexpr uint32_t event_category = 22;
+            constexpr uint32_t event_name = 23;
+            constexpr uint32_t annotation_string = 6;
+            constexpr uint32_t annotation_name = 10;
+
+            constexpr uint64_t type_slice_begin = 1;
+            constexpr uint64_t type_slice_end = 2;
+            constexpr uint64_t type_instant = 3;
+
+            constexpr uint64_t clock_monotonic = 3;
+            constexpr uint64_t clock_boottime = 6;
+        } // namespace pf
+    } // namespace
+} // namespace sw::trace::detail
+
+namespace sw::trace {
+    void start(const std::size_t events_per_thread) {
+        auto& r = detail::get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.capacity.store(events_per_thread, std::memory_order_relaxed);
+        r.epoch.fetch_add(1, std::memory_order_release);
+        detail::g_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() { detail::g_enabled.store(false, std::memory_order_relaxed); }
+
+    void set_thread_name(const char* name) {
+        auto& buffer = detail::local_buffer();
+        std::lock_guard<std::mutex> lock(detail::get_registry().mutex);
+        buffer.name = name;
+    }
+
+    std::size_t get_dropped_count() {
+        std::size_t dropped = 0;
+        detail::for_each_buffer([&](const detail::thread_buffer& buffer, std::size_t) {
+            dropped += buffer.dropped.load(std::memory_order_relaxed);
+        });
+        return dropped;
+    }
+
+    bool write_chrome_json(const char* path) {
+        std::FILE* file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        const uint32_t pid = detail::current_pid();
+        const char* separator = "\n";
+        std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        detail::for_each_buffer([&](const detail::thread_buffer& buffer, std::size_t count) {
+            if (!buffer.name.empty()) {
+                std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+                                   "\"tid\":%u,\"args\":{\"name\":",
+                             separator, pid, buffer.tid);
+                detail::write_json_string(file, buffer.name.c_str());
+                std::fprintf(file, "}}");
+                separator = ",\n";
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto& record = buffer.records[i];
+                static constexpr const char* phases[] = {"B", "E", "i"};
+                std::fprintf(file, "%s{\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u",
+                             separator, phases[static_cast<int>(record.ph)],
+                             static_cast<double>(record.time) / 1000.0, pid, buffer.tid);
+                separator = ",\n";
+
+                if (record.ph != detail::phase::e_end) {
+                    std::fprintf(file, ",\"cat\":\"simple_window\",\"name\":");
+                    detail::write_json_string(file, record.name);
+                }
+                if (record.ph == detail::phase::e_instant) {
+                    std::fprintf(file, ",\"s\":\"t\"");
+                }
+                if (record.detail != nullptr) {
+                    std::fprintf(file, ",\"args\":{\"detail\":");
+                    detail::write_json_string(file, record.detail);
+                    std::fprintf(file, "}");
+                }
+                std::fprintf(file, "}");
+            }
+        });
+        std::fprintf(file, "\n]}\n");
+
+        return std::fclose(file) == 0;
+    }
+
+    bool write_perfetto(const char* path) {
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        namespace pf = detail::pf;
+        const uint32_t pid = detail::current_pid();
+        uint32_t sequence = 0;
+
+        // Packets are written one at a time, a trace of many events is never held in memory
+        detail::proto_writer packet, event, nested, trace;
+        auto write_packet = [&]() {
+            trace.message(pf::trace_packet, packet);
+            std::fwrite(trace.data().data(), 1, trace.data().size(), file);
+            trace.clear();
+            packet.clear();
+        };
+
+#if defined(__linux__)
+        // Perfetto traces default to the boot clock, the snapshot lets it convert the
+        // monotonic timestamps below and merge them with other traces
+        {
+            timespec boot;
+            clock_gettime(CLOCK_BOOTTIME, &boot);
+            const uint64_t monotonic = detail::now_ns();
+
+            nested.varint(pf::clock_id, pf::clock_boottime);
+            nested.varint(pf::clock_timestamp, uint64_t(boot.tv_sec) * 1000000000 + boot.tv_nsec);
+            event.message(pf::snapshot_clock, nested);
+            nested.clear();
+            nested.varint(pf::clock_id, pf::clock_monotonic);
+            nested.varint(pf::clock_timestamp, monotonic);
+            event.message(pf::snapshot_clock, nested);
+            nested.clear();
+            packet.message(pf::packet_clock_snapshot, event);
+            write_packet();
+            event.clear();
+        }
+#endif
+
+        detail::for_each_buffer([&](const detail::thread_buffer& buffer, std::size_t count) {
+            const uint64_t track = uint64_t(pid) << 32 | buffer.tid;
+            ++sequence;
+
+            nested.varint(pf::thread_pid, pid);
+            nested.varint(pf::thread_tid, buffer.tid);
+            if (!buffer.name.empty()) {
+                nested.string(pf::thread_name, buffer.name);
+            }
+            event.varint(pf::descriptor_uuid, track);
+            event.message(pf::descriptor_thread, nested);
+            packet.varint(pf::packet_sequence_id, sequence);
+            packet.message(pf::packet_track_descriptor, event);
+            write_packet();
+            nested.clear();
+            event.clear();
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto& record = buffer.records[i];
+                static constexpr uint64_t types[] = {pf::type_slice_begin, pf::type_slice_end,
+                                                     pf::type_instant};
+                event.varint(pf::event_type, types[static_cast<int>(record.ph)]);
+                event.varint(pf::event_track_uuid, track);
+                if (record.ph != detail::phase::e_end) {
+                    event.string(pf::event_category, "simple_window");
+                    event.string(pf::event_name, record.name);
+                }
+                if (record.detail != nullptr) {
+                    nested.string(pf::annotation_name, "detail");
+                    nested.string(pf::annotation_string, record.detail);
+                    event.message(pf::event_debug_annotation, nested);
+                    nested.clear();
+                }
+
+                packet.varint(pf::packet_timestamp, record.time);
+#if defined(__linux__)
+                packet.varint(pf::packet_clock_id, pf::clock_monotonic);
+#endif
+                packet.message(pf::packet_track_event, event);
+                packet.varint(pf::packet_sequence_id, sequence);
+                write_packet();
+                event.clear();
+            }
+        });
+
+        return std::fclose(file) == 0;
+    }
+} // namespace sw::trace
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "simple_window/window_null.hpp"
+
+#include <utility>
+
+namespace sw::detail {
+    window_null::window_null(const char* name, uint32_t width, uint32_t height)
+        : window_base(width, height), m_name(name),
+          m_framebuffer(static_cast<std::size_t>(width) * height),
+          m_created(std::chrono::steady_clock::now()) {
+        // There is nothing to map, the window is shown right away
+        set_visible_flag_true();
+    }
+
+    void window_null::inject_event(const event& e) {
+        {
+            std::lock_guard<std::mutex> lock(m_injected_mutex);
+            m_injected.push_back(e);
+            if (m_injected.back().time == 0) {
+                m_injected.back().time = elapsed_ms();
+            }
+        }
+        m_injected_signal.notify_one();
+    }
+
+    void window_null::set_size(const uint32_t width, const uint32_t height) {
+        inject_event({event_type::e_resize, key_code::e_NONE, mouse_code::e_NONE,
+                      static_cast<int32_t>(width), static_cast<int32_t>(height)});
+        inject_event({event_type::e_resize_end, key_code::e_NONE, mouse_code::e_NONE,
+                      static_cast<int32_t>(width), static_cast<int32_t>(height)});
+    }
+
+    void window_null::set_fullscreen(const bool fullscreen) {
+        fullscreen ? set_fullscreen_flag_true() : set_fullscreen_flag_false();
+    }
+
+    void window_null::set_cursor_pos(const int32_t x, const int32_t y, bool) {
+        inject_event({event_type::e_mouse_move, key_code::e_NONE, mouse_code::e_NONE, x, y});
+    }
+
+    bool window_null::request_clipboard(const clipboard_selection selection) {
+        if (m_clipboard_request >= 0) {
+            return false;
+        }
+        m_clipboard_request = static_cast<int>(selection);
+        return true;
+    }
+
+    void window_null::suspend() {
+        drop_events();
+        set_open_flag_false();
+        publish_state();
+    }
+
+    void window_null::resume(const char* name, const uint32_t width, const uint32_t height) {
+        drop_events();
+        m_name = name;
+        m_width = width;
+        m_height = height;
+        m_framebuffer.assign(static_cast<std::size_t>(width) * height, 0);
+        set_cursor_flag_false();
+        set_fullscreen_flag_false();
+        set_open_flag_true();
+        request_redraw();
+        publish_state();
+    }
+
+    void window_null::take_injected(std::vector<event>& events) {
+        std::lock_guard<std::mutex> lock(m_injected_mutex);
+        events.insert(events.end(), m_injected.begin(), m_injected.end());
+        m_injected.clear();
+    }
+
+    void window_null::wait_injected(const int timeout_ms) {
+        std::unique_lock<std::mutex> lock(m_injected_mutex);
+        auto injected = [this]() { return !m_injected.empty(); };
+        if (timeout_ms < 0) {
+            m_injected_signal.wait(lock, injected);
+        }
+        else {
+            m_injected_signal.wait_for(lock, std::chrono::milliseconds(timeout_ms), injected);
+        }
+    }
+
+    void window_null::apply_event(const event& e) {
+        switch (e.type) {
+            case event_type::e_close: set_open_flag_false(); break;
+            case event_type::e_resize: {
+                m_width = static_cast<uint32_t>(e.x);
+                m_height = static_cast<uint32_t>(e.y);
+                m_framebuffer.assign(static_cast<std::size_t>(m_width) * m_height, 0);
+                request_redraw();
+                break;
+            }
+            case event_type::e_mouse_button_down:
+            case event_type::e_mouse_button_up:
+            case event_type::e_mouse_move: handle_mouse_move(e.x, e.y); break;
+            default: break;
+        }
+    }
+
+    bool window_null::take_clipboard_request(std::string_view& data) {
+        if (m_clipboard_request < 0) {
+            return false;
+        }
+        data = m_clipboard[std::exchange(m_clipboard_request, -1)];
+        return true;
+    }
+
+    void window_null::drop_events() {
+        {
+            std::lock_guard<std::mutex> lock(m_injected_mutex);
+            m_injected.clear();
+        }
+        m_pending.clear();
+        m_pending_offset = 0;
+        m_clipboard_request = -1;
+    }
+
+    uint32_t window_null::elapsed_ms() const {
+        using namespace std::chrono;
+        return static_cast<uint32_t>(
+            duration_cast<milliseconds>(steady_clock::now() - m_created).count());
+    }
+} // namespace sw::detail
\ No newline at end of file
@@ -39,6 +39,9 @@ namespace sw::detail {
         win32_assert(m_handle);
 
         SetWindowLongPtr(m_handle, GWLP_USERDATA, (LONG_PTR)this);
+
+        // Created with WS_VISIBLE
+        set_visible_flag_true();
     }
 
     window_win32::~window_win32() { DestroyWindow(m_handle); }
@@ -226,6 +229,13 @@ namespace sw::detail {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+
+        publish_state();
+    }
+
+    void window_win32::wait_events() {
+        WaitMessage();
+        poll_events();
     }
 
     key_code window_win32::code_to_enum(const uint64_t code, const int64_t param) const {
@@ -342,6 +352,46 @@ namespace sw::detail {
         }
     }
 
+    std::string_view window_win32::translate_char(const WPARAM code) {
+        auto unit = static_cast<uint32_t>(code);
+        if (unit >= 0xD800 && unit < 0xDC00) {
+            m_high_surrogate = static_cast<wchar_t>(unit);
+            return {};
+        }
+        if (unit >= 0xDC00 && unit < 0xE000) {
+            if (m_high_surrogate == 0) {
+                return {};
+            }
+            unit = 0x10000 + ((static_cast<uint32_t>(m_high_surrogate) - 0xD800) << 10) +
+                   (unit - 0xDC00);
+        }
+        m_high_surrogate = 0;
+
+        if (unit == 0 || unit > 0x10FFFF) {
+            return {};
+        }
+        if (unit < 0x80) {
+            m_char_text[0] = static_cast<char>(unit);
+            return {m_char_text, 1};
+        }
+        if (unit < 0x800) {
+            m_char_text[0] = static_cast<char>(0xC0 | (unit >> 6));
+            m_char_text[1] = static_cast<char>(0x80 | (unit & 0x3F));
+            return {m_char_text, 2};
+        }
+        if (unit < 0x10000) {
+            m_char_text[0] = static_cast<char>(0xE0 | (unit >> 12));
+            m_char_text[1] = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+            m_char_text[2] = static_cast<char>(0x80 | (unit & 0x3F));
+            return {m_char_text, 3};
+        }
+        m_char_text[0] = static_cast<char>(0xF0 | (unit >> 18));
+        m_char_text[1] = static_cast<char>(0x80 | ((unit >> 12) & 0x3F));
+        m_char_text[2] = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+        m_char_text[3] = static_cast<char>(0x80 | (unit & 0x3F));
+        return {m_char_text, 4};
+    }
+
     std::string window_win32::wide_to_multi(const std::wstring& wstr) const {
         std::string str;
 
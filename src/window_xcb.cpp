@@ -1,12 +1,27 @@
 #include "simple_window/window_xcb.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
+#include <iterator>
+#include <utility>
 
+#include <xcb/xcbext.h>
 #include <xcb/xcb_cursor.h>
+#include <xcb/sync.h>
+#include <xcb/randr.h>
+#include <xcb/xkb.h>
+
+#include <xkbcommon/xkbcommon.h>
+#include <xkbcommon/xkbcommon-compose.h>
+#include <xkbcommon/xkbcommon-x11.h>
 
 namespace sw::detail {
-    window_xcb::window_xcb(const char* name, uint32_t width, uint32_t height)
+    window_xcb::window_xcb(const char* name, uint32_t width, uint32_t height,
+                           window_visual visual, bool sync_request, bool drop_target,
+                           bool text_input)
         : window_base(width, height), m_connection(xcb_connect(nullptr, nullptr)) {
         if (xcb_connection_has_error(m_connection) > 0) {
             throw std::runtime_error("simple_window: Failed to make connection to xcb");
@@ -19,99 +34,437 @@ namespace sw::detail {
             m_height = m_screen->height_in_pixels;
         }
 
+        // Visual selection, a visual the compositor has to convert or blend costs a copy
+        {
+            const uint8_t depth = visual == window_visual::e_transparent ? 32 : 24;
+            if (auto* visual_type = find_visual(depth)) {
+                m_visual_id = visual_type->visual_id;
+                m_depth = depth;
+            }
+            else if (visual == window_visual::e_transparent) {
+                throw std::runtime_error("simple_window: No 32 bit ARGB visual available");
+            }
+            else {
+                m_visual_id = m_screen->root_visual;
+                m_depth = m_screen->root_depth;
+            }
+        }
+
         // Window creation
         {
-            uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+            uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK;
             // clang-format off
-            uint32_t values[2] = {
-                m_screen->white_pixel,
+            uint32_t values[4] = {
+                visual == window_visual::e_transparent ? 0 : m_screen->white_pixel,
+
+                0,
 
                 XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_STRUCTURE_NOTIFY | 
                 XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW |  
                 XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE | 
                 XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | 
-                XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_FOCUS_CHANGE
+                XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_FOCUS_CHANGE |
+                XCB_EVENT_MASK_VISIBILITY_CHANGE | XCB_EVENT_MASK_PROPERTY_CHANGE
             };
             // clang-format on
 
+            // Windows with a visual other than the root visual need their own colormap
+            if (m_visual_id != m_screen->root_visual) {
+                m_colormap = xcb_generate_id(m_connection);
+                xcb_create_colormap(m_connection, XCB_COLORMAP_ALLOC_NONE, m_colormap,
+                                    m_screen->root, m_visual_id);
+                mask |= XCB_CW_COLORMAP;
+                values[3] = m_colormap;
+            }
+
             m_window = xcb_generate_id(m_connection);
 
-            xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, m_window, m_screen->root, 10, 10,
-                              m_width, m_height, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
-                              m_screen->root_visual, mask, values);
+            xcb_create_window(m_connection, m_depth, m_window, m_screen->root, m_x, m_y, m_width,
+                              m_height, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT, m_visual_id, mask,
+                              values);
         }
 
         // Window delete event setup
         {
             auto reply = intern_atom_helper(true, "WM_PROTOCOLS");
             m_delete_window_atom = intern_atom_helper(false, "WM_DELETE_WINDOW");
+
+            xcb_atom_t protocols[2] = {m_delete_window_atom->atom};
+            uint32_t protocol_count = 1;
+            if (sync_request && create_sync_counter()) {
+                protocols[protocol_count++] = m_sync_request_atom;
+            }
+
             xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, (*reply).atom, 4, 32,
-                                1, &(*m_delete_window_atom).atom);
+                                protocol_count, protocols);
 
             free(reply);
         }
 
+        // Client message sent to ourselves to wake the owning thread when commands are posted
+        m_wake_atom = intern_atom_helper(false, "_SW_COMMAND_WAKE");
+
+        init_randr();
+
+        {
+            const char* const names[] = {"_NET_WM_STATE", "_NET_WM_STATE_HIDDEN",
+                                         "_NET_WM_STATE_FULLSCREEN", "_NET_WM_BYPASS_COMPOSITOR"};
+            xcb_atom_t atoms[std::size(names)];
+            intern_atoms(names, atoms, std::size(names));
+
+            m_wm_state_atom = atoms[0];
+            m_wm_state_hidden_atom = atoms[1];
+            m_wm_state_fullscreen_atom = atoms[2];
+            m_bypass_compositor_atom = atoms[3];
+        }
+
+        // Clipboard and drag and drop atoms
+        {
+            const char* const names[] = {"CLIPBOARD", "UTF8_STRING",  "TEXT",
+                                         "text/plain;charset=utf-8", "TARGETS", "INCR",
+                                         "_SW_SELECTION", "_SW_DROP"};
+            xcb_atom_t atoms[std::size(names)];
+            intern_atoms(names, atoms, std::size(names));
+
+            m_clipboard_atom = atoms[0];
+            m_utf8_atom = atoms[1];
+            m_text_atom = atoms[2];
+            m_mime_text_atom = atoms[3];
+            m_targets_atom = atoms[4];
+            m_incr_atom = atoms[5];
+            m_selection_property_atom = atoms[6];
+            m_drop_property_atom = atoms[7];
+
+            // Same order as xdnd_atom
+            const char* const xdnd_names[] = {
+                "XdndAware",    "XdndEnter",    "XdndPosition",    "XdndStatus",
+                "XdndLeave",    "XdndDrop",     "XdndFinished",    "XdndSelection",
+                "XdndTypeList", "XdndActionCopy", "text/uri-list"};
+            intern_atoms(xdnd_names, m_xdnd_atoms, e_xdnd_atom_count);
+
+            m_selection_readers[static_cast<int>(selection_purpose::e_clipboard)].property =
+                m_selection_property_atom;
+            m_selection_readers[static_cast<int>(selection_purpose::e_drop)].property =
+                m_drop_property_atom;
+        }
+
+        if (text_input) {
+            init_xkb();
+        }
+
+        if (drop_target) {
+            const uint32_t xdnd_version = 5;
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window,
+                                m_xdnd_atoms[e_xdnd_aware], XCB_ATOM_ATOM, 32, 1, &xdnd_version);
+        }
+
         set_name(name);
 
         xcb_map_window(m_connection, m_window);
         xcb_flush(m_connection);
+
+        m_delivered_width = m_width;
+        m_delivered_height = m_height;
+
+        publish_state();
+    }
+
+    window_xcb::window_xcb(detached_t, uint32_t width, uint32_t height)
+        : window_base(width, height), m_connection(xcb_connect_to_fd(-1, nullptr)),
+          m_screen(nullptr), m_window(XCB_NONE), m_visual_id(0), m_depth(24),
+          m_delete_window_atom(static_cast<xcb_intern_atom_reply_t*>(
+              calloc(1, sizeof(xcb_intern_atom_reply_t)))),
+          m_wake_atom(static_cast<xcb_intern_atom_reply_t*>(
+              calloc(1, sizeof(xcb_intern_atom_reply_t)))) {
+        m_clipboard_atom = m_utf8_atom = m_text_atom = m_mime_text_atom = XCB_NONE;
+        m_targets_atom = m_incr_atom = XCB_NONE;
+        m_selection_property_atom = m_drop_property_atom = XCB_NONE;
+        m_wm_state_atom = m_wm_state_hidden_atom = XCB_NONE;
+        std::fill(std::begin(m_xdnd_atoms), std::end(m_xdnd_atoms), XCB_NONE);
+
+        m_mapped = true;
+        set_visible_flag_true();
+        m_delivered_width = m_width;
+        m_delivered_height = m_height;
+
+        publish_state();
     }
 
     window_xcb::~window_xcb() {
+        release_xkb();
+        for (auto* event : m_backlog) {
+            free(event);
+        }
+        free(m_backlog_prev);
+        free(m_wake_atom);
         free(m_delete_window_atom);
+        if (m_sync_counter != XCB_NONE) {
+            xcb_sync_destroy_counter(m_connection, m_sync_counter);
+        }
         xcb_destroy_window(m_connection, m_window);
+        if (m_colormap != XCB_NONE) {
+            xcb_free_colormap(m_connection, m_colormap);
+        }
         xcb_disconnect(m_connection);
     }
 
-    void window_xcb::set_size(const uint32_t width, const uint32_t height) {
+    bool window_xcb::is_display_available() {
+        auto* connection = xcb_connect(nullptr, nullptr);
+        const bool available = xcb_connection_has_error(connection) == 0;
+        xcb_disconnect(connection);
+        return available;
+    }
+
+    void window_xcb::suspend() {
         if (is_fullscreen()) {
-            return;
+            set_fullscreen(false);
+        }
+        unlock_cursor();
+
+        for (int i = 0; i < 2; ++i) {
+            if (m_owned_selections[i]) {
+                xcb_set_selection_owner(m_connection, XCB_NONE,
+                                        selection_atom(static_cast<clipboard_selection>(i)),
+                                        XCB_CURRENT_TIME);
+                m_owned_selections[i].reset();
+            }
         }
 
         xcb_unmap_window(m_connection, m_window);
+        // ICCCM 4.1.4, a reparented window is withdrawn with a synthetic UnmapNotify on the root
+        if (m_reparented) {
+            xcb_unmap_notify_event_t notify = {};
+            notify.response_type = XCB_UNMAP_NOTIFY;
+            notify.event = m_screen->root;
+            notify.window = m_window;
+            xcb_send_event(m_connection, false, m_screen->root,
+                           XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
+                               XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                           reinterpret_cast<const char*>(&notify));
+        }
+        // Round trip so the events sent up to the unmap are read and dropped with the rest
+        free(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), nullptr));
 
-        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_WIDTH, &width);
+        discard_events();
 
-        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_HEIGHT, &height);
+        // Commands posted for the previous user are dropped, their futures still complete
+        m_wake_pending.store(false, std::memory_order_release);
+        window_command command;
+        while (m_commands.pop(command)) {
+            command.done.set_value();
+        }
 
-        xcb_map_window(m_connection, m_window);
-        xcb_flush(m_connection);
+        // A half typed compose sequence must not continue into the next user's text
+        if (m_compose_state != nullptr) {
+            xkb_compose_state_reset(m_compose_state);
+        }
+
+        set_open_flag_false();
+        set_visible_flag_false();
+        m_mapped = false;
+        publish_state();
     }
 
-    void window_xcb::set_fullscreen(bool fullscreen) {
-        if (is_fullscreen() == fullscreen) {
+    void window_xcb::resume(const char* name, uint32_t width, uint32_t height) {
+        if (is_detached()) {
             return;
         }
 
-        fullscreen == true ? set_fullscreen_flag_true() : set_fullscreen_flag_false();
+        // Whatever arrived while suspended belongs to the previous user of the window
+        discard_events();
 
-        xcb_unmap_window(m_connection, m_window);
+        if (width == 0 || height == 0) {
+            width = m_screen->width_in_pixels;
+            height = m_screen->height_in_pixels;
+        }
+        const uint32_t size[2] = {width, height};
+        xcb_configure_window(m_connection, m_window,
+                             XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, size);
+        change_name(name);
+        xcb_map_window(m_connection, m_window);
+        xcb_flush(m_connection);
 
-        if (fullscreen) {
-            auto* atom_wm_state = intern_atom_helper(false, "_NET_WM_STATE");
+        m_width = m_delivered_width = width;
+        m_height = m_delivered_height = height;
+        m_resize_pending = m_resize_active = false;
+        m_reparented = m_obscured = m_hidden = false;
+        m_input = {};
+        m_pointer_count = 0;
+        m_expose_count = 0;
+        m_clipboard_pending.clear();
+
+        // Visible again once the MapNotify arrives
+        set_open_flag_true();
+        request_redraw();
+        publish_state();
+    }
+
+    void window_xcb::discard_events() {
+        drop_queued_events();
+
+        for (auto& reader : m_selection_readers) {
+            if (reader.cookie_pending) {
+                xcb_discard_reply(m_connection, reader.cookie.sequence);
+            }
+            reader.state = selection_read_state::e_idle;
+            reader.offset = 0;
+            reader.cookie_pending = false;
+            reader.failed = false;
+            reader.local.reset();
+        }
+        if (m_motion_cookie_pending) {
+            xcb_discard_reply(m_connection, m_motion_cookie.sequence);
+            m_motion_cookie_pending = false;
+        }
+        for (auto& transfer : m_selection_transfers) {
+            if (transfer.owns_mask) {
+                restore_requestor_mask(transfer);
+            }
+        }
+        m_selection_transfers.clear();
 
-            auto* atom_wm_fullscreen = intern_atom_helper(false, "_NET_WM_STATE_FULLSCREEN");
+        if (m_drop_types_pending) {
+            xcb_discard_reply(m_connection, m_drop_types_cookie.sequence);
+            m_drop_types_pending = false;
+        }
+        if (m_root_offset_pending) {
+            xcb_discard_reply(m_connection, m_root_offset_cookie.sequence);
+            m_root_offset_pending = false;
+        }
+        m_root_offset_dirty = true;
 
-            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, atom_wm_state->atom,
-                                XCB_ATOM_ATOM, 32, 1, &(atom_wm_fullscreen->atom));
+        m_drop_source = XCB_NONE;
+        m_drop_accepted = false;
+        m_drop_position_pending = false;
+        m_sync_pending = false;
+    }
 
-            free(atom_wm_fullscreen);
-            free(atom_wm_state);
+    void window_xcb::drop_queued_events() {
+        for (auto* event : m_backlog) {
+            free(event);
+        }
+        m_backlog.clear();
+        free(m_backlog_prev);
+        m_backlog_prev = nullptr;
+        while (auto* event = xcb_poll_for_event(m_connection)) {
+            free(event);
+        }
+    }
 
-            m_width = m_screen->width_in_pixels;
-            m_height = m_screen->height_in_pixels;
+    void window_xcb::drop_live_input() {
+        // The backlog is left alone, it holds the replayed events deferred by the budget
+        while (auto* event = xcb_poll_for_event(m_connection)) {
+            if (is_replayable(event)) {
+                free(event);
+            }
+            else {
+                m_backlog.push_back(event);
+            }
         }
+    }
 
-        xcb_map_window(m_connection, m_window);
+    void window_xcb::set_size(const uint32_t width, const uint32_t height) {
+        change_size(width, height);
         xcb_flush(m_connection);
+    }
+
+    void window_xcb::change_size(const uint32_t width, const uint32_t height) {
+        if (is_fullscreen()) {
+            return;
+        }
 
         xcb_unmap_window(m_connection, m_window);
 
-        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_WIDTH, &m_width);
+        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_WIDTH, &width);
 
-        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_HEIGHT, &m_height);
+        xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_HEIGHT, &height);
 
         xcb_map_window(m_connection, m_window);
+    }
+
+    namespace {
+        constexpr uint32_t size_hint_min_size = 1 << 4;
+        constexpr uint32_t size_hint_max_size = 1 << 5;
+        constexpr uint32_t size_hint_resize_inc = 1 << 6;
+        constexpr uint32_t size_hint_aspect = 1 << 7;
+        constexpr uint32_t size_hint_base_size = 1 << 8;
+    } // namespace
+
+    void window_xcb::set_min_size(const uint32_t width, const uint32_t height) {
+        m_size_hints.min_width = static_cast<int32_t>(width);
+        m_size_hints.min_height = static_cast<int32_t>(height);
+        update_size_hints(size_hint_min_size, width != 0 || height != 0);
+    }
+
+    void window_xcb::set_max_size(const uint32_t width, const uint32_t height) {
+        // Like the min size a zero dimension is unconstrained, the hint has no way to leave out
+        // one dimension so it gets the largest size X allows
+        constexpr int32_t unconstrained = 65535;
+        m_size_hints.max_width = width != 0 ? static_cast<int32_t>(width) : unconstrained;
+        m_size_hints.max_height = height != 0 ? static_cast<int32_t>(height) : unconstrained;
+        update_size_hints(size_hint_max_size, width != 0 || height != 0);
+    }
+
+    void window_xcb::set_aspect_ratio(const uint32_t numerator, const uint32_t denominator) {
+        m_size_hints.min_aspect_num = m_size_hints.max_aspect_num = static_cast<int32_t>(numerator);
+        m_size_hints.min_aspect_den = m_size_hints.max_aspect_den =
+            static_cast<int32_t>(denominator);
+        update_size_hints(size_hint_aspect, numerator != 0 && denominator != 0);
+    }
+
+    void window_xcb::set_resize_increment(const uint32_t width, const uint32_t height) {
+        m_size_hints.width_inc = static_cast<int32_t>(width);
+        m_size_hints.height_inc = static_cast<int32_t>(height);
+
+        // Without an explicit base size window managers count increments from the min size
+        update_size_hints(size_hint_resize_inc | size_hint_base_size, width != 0 && height != 0);
+    }
+
+    void window_xcb::update_size_hints(const uint32_t flag, const bool enable) {
+        enable ? m_size_hints.flags |= flag : m_size_hints.flags &= ~flag;
+
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window,
+                            XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 32,
+                            sizeof(size_hints) / sizeof(uint32_t), &m_size_hints);
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::set_fullscreen(bool fullscreen) {
+        if (is_fullscreen() == fullscreen || is_detached()) {
+            return;
+        }
+
+        fullscreen == true ? set_fullscreen_flag_true() : set_fullscreen_flag_false();
+
+        // The window manager fullscreens on the monitor the window is placed on
+        if (fullscreen) {
+            if (const auto* current = get_current_monitor()) {
+                const int32_t position[2] = {current->x, current->y};
+                xcb_configure_window(m_connection, m_window,
+                                     XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, position);
+            }
+        }
+
+        // EWMH, the window manager toggles the state so the other states it set are kept. The
+        // new size arrives as a configure event.
+        xcb_client_message_event_t message = {};
+        message.response_type = XCB_CLIENT_MESSAGE;
+        message.format = 32;
+        message.window = m_window;
+        message.type = m_wm_state_atom;
+        // _NET_WM_STATE_ADD or _NET_WM_STATE_REMOVE, the source is a normal application
+        message.data.data32[0] = fullscreen ? 1 : 0;
+        message.data.data32[1] = m_wm_state_fullscreen_atom;
+        message.data.data32[3] = 1;
+        xcb_send_event(m_connection, false, m_screen->root,
+                       XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                       reinterpret_cast<const char*>(&message));
+
+        // Asks the compositor to unredirect the window, 1 requests bypass and 0 is no preference
+        const uint32_t bypass = fullscreen ? 1 : 0;
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window,
+                            m_bypass_compositor_atom, XCB_ATOM_CARDINAL, 32, 1, &bypass);
+
         xcb_flush(m_connection);
     }
 
@@ -127,6 +480,10 @@ namespace sw::detail {
     void window_xcb::unlock_cursor() { set_cursor_flag_false(); }
 
     void window_xcb::hide_cursor() {
+        if (is_detached()) {
+            return;
+        }
+
         // Create blank cursor
         xcb_cursor_t empty_cursor = xcb_generate_id(m_connection);
         {
@@ -165,6 +522,15 @@ namespace sw::detail {
     void window_xcb::show_cursor() { set_cursor_image(cursor_icon::e_arrow); }
 
     void window_xcb::set_cursor_image(cursor_icon cursor) {
+        change_cursor_image(cursor);
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::change_cursor_image(cursor_icon cursor) {
+        if (is_detached()) {
+            return;
+        }
+
         if (xcb_cursor_context_t * context;
             xcb_cursor_context_new(m_connection, m_screen, &context) >= 0) {
             xcb_cursor_t cursor_image;
@@ -200,7 +566,6 @@ namespace sw::detail {
             }
 
             xcb_change_window_attributes(m_connection, m_window, XCB_CW_CURSOR, &cursor_image);
-            xcb_flush(m_connection);
             xcb_cursor_context_free(context);
         }
         else {
@@ -209,19 +574,55 @@ namespace sw::detail {
     }
 
     void window_xcb::set_cursor_pos(const int32_t x, const int32_t y, const bool screenspace) {
+        warp_cursor(x, y, screenspace);
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::warp_cursor(const int32_t x, const int32_t y, const bool screenspace) {
+        if (is_detached()) {
+            return;
+        }
         xcb_warp_pointer(m_connection, XCB_NONE, screenspace ? XCB_NONE : m_window, 0, 0,
                          m_screen->width_in_pixels, m_screen->height_in_pixels, x, y);
-
-        xcb_flush(m_connection);
     }
 
     std::string window_xcb::get_clipboard() const {
-        return std::string();
-        // TODO: implement
+        if (const auto& owned = m_owned_selections[0]) {
+            return *owned;
+        }
+        return m_clipboard_text;
+    }
+
+    void window_xcb::set_clipboard(const std::string& data, const clipboard_selection selection) {
+        // Transfers still in flight keep a reference to the text they started with
+        m_owned_selections[static_cast<int>(selection)] =
+            std::make_shared<const std::string>(data);
+
+        xcb_set_selection_owner(m_connection, m_window, selection_atom(selection),
+                                XCB_CURRENT_TIME);
+        xcb_flush(m_connection);
     }
 
-    void window_xcb::set_clipboard(const std::string& data) {
-        // TODO: implement
+    bool window_xcb::request_clipboard(const clipboard_selection selection) {
+        auto& reader = m_selection_readers[static_cast<int>(selection_purpose::e_clipboard)];
+        if (reader.state != selection_read_state::e_idle) {
+            return false;
+        }
+        m_clipboard_pending.clear();
+
+        // Converting a selection we own would make this window its own INCR requestor
+        if (const auto& owned = m_owned_selections[static_cast<int>(selection)]) {
+            reader.local = owned;
+            reader.state = selection_read_state::e_reading;
+            return true;
+        }
+
+        xcb_convert_selection(m_connection, m_window, selection_atom(selection), m_utf8_atom,
+                              reader.property, XCB_CURRENT_TIME);
+        xcb_flush(m_connection);
+
+        reader.state = selection_read_state::e_converting;
+        return true;
     }
 
     std::string window_xcb::get_name() const {
@@ -237,38 +638,1626 @@ namespace sw::detail {
     }
 
     void window_xcb::set_name(const std::string& name) {
+        change_name(name);
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::change_name(const std::string& name) {
         xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, XCB_ATOM_WM_NAME,
                             XCB_ATOM_STRING, 8, name.size(), name.c_str());
+    }
+
+    std::future<void> window_xcb::post_set_name(std::string name) {
+        window_command command;
+        command.command = window_command::type::e_name;
+        command.name = std::move(name);
+        return post_command(std::move(command));
+    }
+
+    std::future<void> window_xcb::post_set_size(const uint32_t width, const uint32_t height) {
+        window_command command;
+        command.command = window_command::type::e_size;
+        command.width = width;
+        command.height = height;
+        return post_command(std::move(command));
+    }
+
+    std::future<void> window_xcb::post_set_fullscreen(const bool fullscreen) {
+        window_command command;
+        command.command = window_command::type::e_fullscreen;
+        command.flag = fullscreen;
+        return post_command(std::move(command));
+    }
+
+    std::future<void> window_xcb::post_set_cursor_image(const cursor_icon cursor) {
+        window_command command;
+        command.command = window_command::type::e_cursor_image;
+        command.cursor = cursor;
+        return post_command(std::move(command));
+    }
+
+    std::future<void> window_xcb::post_set_cursor_pos(const int32_t x, const int32_t y,
+                                                      const bool screenspace) {
+        window_command command;
+        command.command = window_command::type::e_cursor_pos;
+        command.x = x;
+        command.y = y;
+        command.flag = screenspace;
+        return post_command(std::move(command));
+    }
+
+    std::future<void> window_xcb::post_command(window_command&& command) {
+        auto future = command.done.get_future();
+        m_commands.push(std::move(command));
+
+        // Only the first post after a batch was applied needs to wake the owning thread,
+        // xcb connections are safe to use from any thread
+        if (!m_wake_pending.exchange(true, std::memory_order_acq_rel)) {
+            xcb_client_message_event_t wake = {};
+            wake.response_type = XCB_CLIENT_MESSAGE;
+            wake.format = 32;
+            wake.window = m_window;
+            wake.type = m_wake_atom->atom;
+
+            xcb_send_event(m_connection, 0, m_window, XCB_EVENT_MASK_NO_EVENT,
+                           reinterpret_cast<const char*>(&wake));
+            xcb_flush(m_connection);
+        }
+        return future;
+    }
+
+    void window_xcb::apply_posted_commands() {
+        if (!m_wake_pending.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        window_command command;
+        while (m_commands.pop(command)) {
+            switch (command.command) {
+                case window_command::type::e_name: change_name(command.name); break;
+                case window_command::type::e_size: change_size(command.width, command.height); break;
+                case window_command::type::e_fullscreen: set_fullscreen(command.flag); break;
+                case window_command::type::e_cursor_image: change_cursor_image(command.cursor); break;
+                case window_command::type::e_cursor_pos:
+                    warp_cursor(command.x, command.y, command.flag);
+                    break;
+            }
+            command.done.set_value();
+        }
         xcb_flush(m_connection);
     }
 
-    bool window_xcb::is_close_event(const xcb_generic_event_t* event) const {
-        auto client_event = reinterpret_cast<const xcb_client_message_event_t*>(event);
-        return client_event->data.data32[0] == m_delete_window_atom->atom;
+    void window_xcb::set_resize_throttle(const std::chrono::milliseconds interval) {
+        m_resize_throttle = interval;
     }
 
-    bool window_xcb::is_key_down_event(const xcb_generic_event_t* event,
-                                       const xcb_generic_event_t* prev) const {
-        auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(event);
-        auto prev_event = reinterpret_cast<const xcb_key_release_event_t*>(prev);
-        return !(prev && ((prev->response_type & ~0x80) == XCB_KEY_RELEASE) &&
-                (prev_event->detail == key_event->detail) && (prev_event->time == key_event->time));
+    void window_xcb::set_resize_end_delay(const std::chrono::milliseconds delay) {
+        m_resize_end_delay = delay;
     }
 
-    bool window_xcb::is_key_up_event(const xcb_generic_event_t* event,
-                                     const xcb_generic_event_t* next) const {
-        auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(event);
-        auto next_event = reinterpret_cast<const xcb_key_release_event_t*>(next);
-        return !(next && ((next->response_type & ~0x80) == XCB_KEY_PRESS) &&
-                  (next_event->detail == key_event->detail) &&
-                  (next_event->time == key_event->time));
+    int window_xcb::get_dispatch_timeout() const {
+        using namespace std::chrono;
+
+        auto deadline = steady_clock::time_point::max();
+        if (m_resize_pending) {
+            deadline = m_last_resize_delivery + m_resize_throttle;
+        }
+        else if (m_resize_active) {
+            deadline = m_last_configure + m_resize_end_delay;
+        }
+
+        if (m_drop_position_pending) {
+            deadline = std::min(deadline, m_last_drop_position + m_drop_position_throttle);
+        }
+
+        if (deadline == steady_clock::time_point::max()) {
+            return -1;
+        }
+
+        const auto remaining = ceil<milliseconds>(deadline - steady_clock::now()).count();
+        return remaining > 0 ? static_cast<int>(remaining) : 0;
     }
 
-    inline xcb_intern_atom_reply_t* window_xcb::intern_atom_helper(bool only_if_exists,
-                                                                   const char* str) {
-        xcb_intern_atom_cookie_t cookie =
-            xcb_intern_atom(m_connection, only_if_exists, std::strlen(str), str);
-        return xcb_intern_atom_reply(m_connection, cookie, nullptr);
+    void window_xcb::record_resize(const uint32_t width, const uint32_t height) {
+        m_width = width;
+        m_height = height;
+        m_last_configure = std::chrono::steady_clock::now();
+        m_resize_pending = true;
+        m_resize_active = true;
+    }
+
+    bool window_xcb::take_pending_resize() {
+        if (!m_resize_pending) {
+            return false;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - m_last_resize_delivery < m_resize_throttle) {
+            return false;
+        }
+
+        m_resize_pending = false;
+        m_last_resize_delivery = now;
+
+        // Interactive resizes may end up back at the size the application already has
+        if (m_width == m_delivered_width && m_height == m_delivered_height) {
+            return false;
+        }
+        m_delivered_width = m_width;
+        m_delivered_height = m_height;
+        return true;
+    }
+
+    bool window_xcb::take_resize_end() {
+        if (!m_resize_active || m_resize_pending) {
+            return false;
+        }
+
+        if (std::chrono::steady_clock::now() - m_last_configure < m_resize_end_delay) {
+            return false;
+        }
+
+        m_resize_active = false;
+        return true;
+    }
+
+    xcb_visualtype_t* window_xcb::find_visual(const uint8_t depth) const {
+        // Prefer the root visual so no colormap or conversion is needed
+        for (auto depth_it = xcb_screen_allowed_depths_iterator(m_screen); depth_it.rem;
+             xcb_depth_next(&depth_it)) {
+            if (depth_it.data->depth != depth) {
+                continue;
+            }
+
+            xcb_visualtype_t* match = nullptr;
+            for (auto visual_it = xcb_depth_visuals_iterator(depth_it.data); visual_it.rem;
+                 xcb_visualtype_next(&visual_it)) {
+                auto* visual = visual_it.data;
+                if (visual->_class != XCB_VISUAL_CLASS_TRUE_COLOR ||
+                    visual->red_mask != 0xff0000 || visual->green_mask != 0x00ff00 ||
+                    visual->blue_mask != 0x0000ff) {
+                    continue;
+                }
+
+                if (visual->visual_id == m_screen->root_visual) {
+                    return visual;
+                }
+                if (match == nullptr) {
+                    match = visual;
+                }
+            }
+
+            if (match != nullptr) {
+                return match;
+            }
+        }
+        return nullptr;
+    }
+
+    void window_xcb::init_randr() {
+        const auto* extension = xcb_get_extension_data(m_connection, &xcb_randr_id);
+        if (extension == nullptr || !extension->present) {
+            return;
+        }
+
+        // GetScreenResourcesCurrent and GetOutputPrimary need 1.3
+        auto* version = xcb_randr_query_version_reply(
+            m_connection, xcb_randr_query_version(m_connection, 1, 3), nullptr);
+        if (version == nullptr) {
+            return;
+        }
+        const bool supported =
+            version->major_version > 1 || (version->major_version == 1 && version->minor_version >= 3);
+        free(version);
+        if (!supported) {
+            return;
+        }
+
+        m_randr_available = true;
+        m_randr_first_event = extension->first_event;
+
+        xcb_randr_select_input(m_connection, m_window,
+                               XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE |
+                                   XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE |
+                                   XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE);
+        refresh_monitors();
+    }
+
+    void window_xcb::refresh_monitors() {
+        m_monitors.clear();
+        m_monitors_dirty = false;
+
+        auto resources_cookie = xcb_randr_get_screen_resources_current(m_connection, m_screen->root);
+        auto primary_cookie = xcb_randr_get_output_primary(m_connection, m_screen->root);
+
+        auto* resources =
+            xcb_randr_get_screen_resources_current_reply(m_connection, resources_cookie, nullptr);
+        auto* primary = xcb_randr_get_output_primary_reply(m_connection, primary_cookie, nullptr);
+        const xcb_randr_output_t primary_output = primary != nullptr ? primary->output : XCB_NONE;
+        free(primary);
+
+        if (resources == nullptr) {
+            return;
+        }
+
+        const auto* crtcs = xcb_randr_get_screen_resources_current_crtcs(resources);
+        const auto crtc_count = xcb_randr_get_screen_resources_current_crtcs_length(resources);
+        const auto* modes = xcb_randr_get_screen_resources_current_modes(resources);
+        const auto mode_count = xcb_randr_get_screen_resources_current_modes_length(resources);
+
+        // All crtc requests go out before the first reply is awaited, one round trip in total
+        std::vector<xcb_randr_get_crtc_info_cookie_t> cookies(crtc_count);
+        for (int i = 0; i < crtc_count; ++i) {
+            cookies[i] = xcb_randr_get_crtc_info(m_connection, crtcs[i], resources->config_timestamp);
+        }
+
+        for (int i = 0; i < crtc_count; ++i) {
+            auto* crtc = xcb_randr_get_crtc_info_reply(m_connection, cookies[i], nullptr);
+            if (crtc == nullptr) {
+                continue;
+            }
+
+            if (crtc->mode != XCB_NONE && crtc->width != 0 && crtc->height != 0) {
+                monitor entry;
+                entry.x = crtc->x;
+                entry.y = crtc->y;
+                entry.width = crtc->width;
+                entry.height = crtc->height;
+
+                for (int m = 0; m < mode_count; ++m) {
+                    const auto& mode = modes[m];
+                    if (mode.id != crtc->mode || mode.htotal == 0 || mode.vtotal == 0) {
+                        continue;
+                    }
+
+                    double vtotal = mode.vtotal;
+                    if (mode.mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN) {
+                        vtotal *= 2.0;
+                    }
+                    if (mode.mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE) {
+                        vtotal /= 2.0;
+                    }
+                    entry.refresh_rate = mode.dot_clock / (mode.htotal * vtotal);
+                    break;
+                }
+
+                const auto* outputs = xcb_randr_get_crtc_info_outputs(crtc);
+                const auto output_count = xcb_randr_get_crtc_info_outputs_length(crtc);
+                entry.primary =
+                    std::find(outputs, outputs + output_count, primary_output) != outputs + output_count;
+
+                m_monitors.push_back(entry);
+            }
+            free(crtc);
+        }
+        free(resources);
+    }
+
+    const monitor* window_xcb::get_current_monitor() const {
+        const int32_t center_x = m_x + static_cast<int32_t>(m_width / 2);
+        const int32_t center_y = m_y + static_cast<int32_t>(m_height / 2);
+
+        const monitor* fallback = nullptr;
+        for (const auto& entry : m_monitors) {
+            if (center_x >= entry.x && center_x < entry.x + static_cast<int32_t>(entry.width) &&
+                center_y >= entry.y && center_y < entry.y + static_cast<int32_t>(entry.height)) {
+                return &entry;
+            }
+            if (fallback == nullptr || entry.primary) {
+                fallback = &entry;
+            }
+        }
+        return fallback;
+    }
+
+    std::chrono::nanoseconds window_xcb::get_refresh_interval() const {
+        const auto* current = get_current_monitor();
+        if (current == nullptr || current->refresh_rate <= 0.0) {
+            return std::chrono::nanoseconds(0);
+        }
+        return std::chrono::nanoseconds(static_cast<int64_t>(1e9 / current->refresh_rate));
+    }
+
+    bool window_xcb::handle_configure_position(const xcb_generic_event_t* event) {
+        auto config_event = reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+        m_root_offset_dirty = true;
+
+        // Real configure events of a reparented window are relative to the frame, window
+        // managers send synthetic ones in root coordinates
+        const bool synthetic = (event->response_type & 0x80) != 0;
+        if (m_reparented && !synthetic) {
+            return false;
+        }
+
+        if (config_event->x == m_x && config_event->y == m_y) {
+            return false;
+        }
+
+        m_x = config_event->x;
+        m_y = config_event->y;
+        return true;
+    }
+
+    void window_xcb::handle_reparent(const xcb_generic_event_t* event) {
+        auto reparent_event = reinterpret_cast<const xcb_reparent_notify_event_t*>(event);
+        m_reparented = !is_detached() && reparent_event->parent != m_screen->root;
+        m_root_offset_dirty = true;
+    }
+
+    void window_xcb::update_root_offset() {
+        if (m_root_offset_pending) {
+            void* reply = nullptr;
+            xcb_generic_error_t* error = nullptr;
+            if (xcb_poll_for_reply(m_connection, m_root_offset_cookie.sequence, &reply, &error) !=
+                0) {
+                m_root_offset_pending = false;
+                if (reply != nullptr) {
+                    auto* translated = static_cast<xcb_translate_coordinates_reply_t*>(reply);
+                    m_root_x = translated->dst_x;
+                    m_root_y = translated->dst_y;
+                }
+                free(reply);
+                free(error);
+            }
+        }
+
+        // A configure arriving while a request is out is picked up by the next one
+        if (!m_root_offset_dirty || m_root_offset_pending || is_detached()) {
+            return;
+        }
+        m_root_offset_dirty = false;
+        m_root_offset_cookie =
+            xcb_translate_coordinates(m_connection, m_window, m_screen->root, 0, 0);
+        m_root_offset_pending = true;
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::handle_extension_event(const xcb_generic_event_t* event) {
+        const auto type = event->response_type & ~0x80;
+
+        if (m_randr_available && (type == m_randr_first_event + XCB_RANDR_SCREEN_CHANGE_NOTIFY ||
+                                  type == m_randr_first_event + XCB_RANDR_NOTIFY)) {
+            // A configuration change comes as a burst of notifications, rebuild once per poll
+            m_monitors_dirty = true;
+            return;
+        }
+
+        // All xkb events share one event code and carry their type in the second byte
+        if (m_xkb_state != nullptr && type == m_xkb_first_event) {
+            auto state_event = reinterpret_cast<const xcb_xkb_state_notify_event_t*>(event);
+            if (state_event->deviceID != m_xkb_device_id) {
+                return;
+            }
+
+            switch (state_event->xkbType) {
+                case XCB_XKB_STATE_NOTIFY: {
+                    xkb_state_update_mask(m_xkb_state, state_event->baseMods,
+                                          state_event->latchedMods, state_event->lockedMods,
+                                          state_event->baseGroup, state_event->latchedGroup,
+                                          state_event->lockedGroup);
+                    ++m_key_text_generation;
+                    break;
+                }
+                case XCB_XKB_NEW_KEYBOARD_NOTIFY:
+                case XCB_XKB_MAP_NOTIFY: m_keymap_dirty = true; break;
+                default: break;
+            }
+        }
+    }
+
+    void window_xcb::init_xkb() {
+        if (!xkb_x11_setup_xkb_extension(m_connection, XKB_X11_MIN_MAJOR_XKB_VERSION,
+                                         XKB_X11_MIN_MINOR_XKB_VERSION,
+                                         XKB_X11_SETUP_XKB_EXTENSION_NO_FLAGS, nullptr, nullptr,
+                                         &m_xkb_first_event, nullptr)) {
+            return;
+        }
+
+        m_xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        if (m_xkb_context == nullptr) {
+            return;
+        }
+
+        load_keymap();
+        if (m_xkb_state == nullptr) {
+            return;
+        }
+
+        // clang-format off
+        constexpr uint16_t events = 
+            XCB_XKB_EVENT_TYPE_NEW_KEYBOARD_NOTIFY | XCB_XKB_EVENT_TYPE_MAP_NOTIFY | 
+            XCB_XKB_EVENT_TYPE_STATE_NOTIFY;
+        constexpr uint16_t map_parts = 
+            XCB_XKB_MAP_PART_KEY_TYPES | XCB_XKB_MAP_PART_KEY_SYMS | 
+            XCB_XKB_MAP_PART_MODIFIER_MAP | XCB_XKB_MAP_PART_EXPLICIT_COMPONENTS | 
+            XCB_XKB_MAP_PART_KEY_ACTIONS | XCB_XKB_MAP_PART_VIRTUAL_MODS | 
+            XCB_XKB_MAP_PART_VIRTUAL_MOD_MAP;
+        constexpr uint16_t state_parts = 
+            XCB_XKB_STATE_PART_MODIFIER_BASE | XCB_XKB_STATE_PART_MODIFIER_LATCH | 
+            XCB_XKB_STATE_PART_MODIFIER_LOCK | XCB_XKB_STATE_PART_GROUP_BASE | 
+            XCB_XKB_STATE_PART_GROUP_LATCH | XCB_XKB_STATE_PART_GROUP_LOCK;
+        // clang-format on
+
+        xcb_xkb_select_events_details_t details = {};
+        details.affectNewKeyboard = XCB_XKB_NKN_DETAIL_KEYCODES;
+        details.newKeyboardDetails = XCB_XKB_NKN_DETAIL_KEYCODES;
+        details.affectState = state_parts;
+        details.stateDetails = state_parts;
+        xcb_xkb_select_events_aux(m_connection, static_cast<uint16_t>(m_xkb_device_id), events, 0,
+                                  0, map_parts, map_parts, &details);
+
+        // Compose sequences follow the locale, without a table keys are translated one by one
+        const char* locale = std::getenv("LC_ALL");
+        if (locale == nullptr || *locale == '\0') {
+            locale = std::getenv("LC_CTYPE");
+        }
+        if (locale == nullptr || *locale == '\0') {
+            locale = std::getenv("LANG");
+        }
+        if (locale == nullptr || *locale == '\0') {
+            locale = "C";
+        }
+
+        m_compose_table = xkb_compose_table_new_from_locale(m_xkb_context, locale,
+                                                            XKB_COMPOSE_COMPILE_NO_FLAGS);
+        if (m_compose_table != nullptr) {
+            m_compose_state = xkb_compose_state_new(m_compose_table, XKB_COMPOSE_STATE_NO_FLAGS);
+        }
+    }
+
+    void window_xcb::load_keymap() {
+        m_xkb_device_id = xkb_x11_get_core_keyboard_device_id(m_connection);
+        if (m_xkb_device_id < 0) {
+            return;
+        }
+
+        auto* keymap = xkb_x11_keymap_new_from_device(m_xkb_context, m_connection, m_xkb_device_id,
+                                                      XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (keymap == nullptr) {
+            return;
+        }
+
+        auto* state = xkb_x11_state_new_from_device(keymap, m_connection, m_xkb_device_id);
+        if (state == nullptr) {
+            xkb_keymap_unref(keymap);
+            return;
+        }
+
+        xkb_state_unref(m_xkb_state);
+        xkb_keymap_unref(m_xkb_keymap);
+        m_xkb_keymap = keymap;
+        m_xkb_state = state;
+        ++m_key_text_generation;
+    }
+
+    void window_xcb::update_keymap() {
+        if (m_keymap_dirty) {
+            m_keymap_dirty = false;
+            load_keymap();
+            if (m_compose_state != nullptr) {
+                xkb_compose_state_reset(m_compose_state);
+            }
+        }
+    }
+
+    void window_xcb::release_xkb() {
+        xkb_compose_state_unref(m_compose_state);
+        xkb_compose_table_unref(m_compose_table);
+        xkb_state_unref(m_xkb_state);
+        xkb_keymap_unref(m_xkb_keymap);
+        xkb_context_unref(m_xkb_context);
+    }
+
+    std::string_view window_xcb::translate_key_text(const xcb_generic_event_t* event) {
+        if (m_xkb_state == nullptr) {
+            return {};
+        }
+
+        const auto keycode = reinterpret_cast<const xcb_key_press_event_t*>(event)->detail;
+        auto& entry = m_key_text[keycode];
+        if (entry.generation != m_key_text_generation) {
+            entry.generation = m_key_text_generation;
+            entry.keysym = xkb_state_key_get_one_sym(m_xkb_state, keycode);
+            const int length =
+                xkb_state_key_get_utf8(m_xkb_state, keycode, entry.utf8, sizeof(entry.utf8));
+            entry.length = length > 0 && length < static_cast<int>(sizeof(entry.utf8))
+                               ? static_cast<uint8_t>(length)
+                               : 0;
+        }
+
+        if (m_compose_state != nullptr && entry.keysym != XKB_KEY_NoSymbol &&
+            xkb_compose_state_feed(m_compose_state, entry.keysym) == XKB_COMPOSE_FEED_ACCEPTED) {
+            switch (xkb_compose_state_get_status(m_compose_state)) {
+                case XKB_COMPOSE_COMPOSING: return {};
+                case XKB_COMPOSE_CANCELLED: {
+                    xkb_compose_state_reset(m_compose_state);
+                    return {};
+                }
+                case XKB_COMPOSE_COMPOSED: {
+                    const int length = xkb_compose_state_get_utf8(
+                        m_compose_state, m_compose_text, sizeof(m_compose_text));
+                    xkb_compose_state_reset(m_compose_state);
+                    if (length <= 0 || length >= static_cast<int>(sizeof(m_compose_text))) {
+                        return {};
+                    }
+                    return {m_compose_text, static_cast<std::size_t>(length)};
+                }
+                default: break;
+            }
+        }
+
+        return {entry.utf8, entry.length};
+    }
+
+    void window_xcb::update_monitors() {
+        if (m_monitors_dirty) {
+            refresh_monitors();
+        }
+    }
+
+    bool window_xcb::create_sync_counter() {
+        const auto* extension = xcb_get_extension_data(m_connection, &xcb_sync_id);
+        if (extension == nullptr || !extension->present) {
+            return false;
+        }
+
+        auto* version = xcb_sync_initialize_reply(
+            m_connection, xcb_sync_initialize(m_connection, 3, 1), nullptr);
+        if (version == nullptr) {
+            return false;
+        }
+        free(version);
+
+        m_sync_counter = xcb_generate_id(m_connection);
+        xcb_sync_create_counter(m_connection, m_sync_counter, xcb_sync_int64_t{0, 0});
+
+        const auto counter_atom = intern_atom(false, "_NET_WM_SYNC_REQUEST_COUNTER");
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, counter_atom,
+                            XCB_ATOM_CARDINAL, 32, 1, &m_sync_counter);
+
+        m_sync_request_atom = intern_atom(false, "_NET_WM_SYNC_REQUEST");
+        return true;
+    }
+
+    void window_xcb::ack_sync_request() {
+        if (!m_sync_pending) {
+            return;
+        }
+        m_sync_pending = false;
+
+        const xcb_sync_int64_t value = {static_cast<int32_t>(m_sync_value >> 32),
+                                        static_cast<uint32_t>(m_sync_value)};
+        xcb_sync_set_counter(m_connection, m_sync_counter, value);
+        xcb_flush(m_connection);
+    }
+
+    bool window_xcb::handle_sync_request(const xcb_generic_event_t* event) {
+        auto client_event = reinterpret_cast<const xcb_client_message_event_t*>(event);
+        if (m_sync_request_atom == XCB_NONE ||
+            client_event->data.data32[0] != m_sync_request_atom) {
+            return false;
+        }
+
+        m_sync_value = (static_cast<uint64_t>(client_event->data.data32[3]) << 32) |
+                       client_event->data.data32[2];
+        m_sync_pending = true;
+        m_sync_notify = true;
+        return true;
+    }
+
+    bool window_xcb::take_sync_request() {
+        // Keep the request paired with the resize it belongs to when that one is throttled
+        return !m_resize_pending && std::exchange(m_sync_notify, false);
+    }
+
+    namespace {
+        bool touches(const rect& a, const rect& b) {
+            return a.x <= b.x + static_cast<int32_t>(b.width) &&
+                   b.x <= a.x + static_cast<int32_t>(a.width) &&
+                   a.y <= b.y + static_cast<int32_t>(b.height) &&
+                   b.y <= a.y + static_cast<int32_t>(a.height);
+        }
+
+        rect bounds(const rect& a, const rect& b) {
+            const auto x = std::min(a.x, b.x);
+            const auto y = std::min(a.y, b.y);
+            const auto right = std::max(a.x + static_cast<int32_t>(a.width),
+                                        b.x + static_cast<int32_t>(b.width));
+            const auto bottom = std::max(a.y + static_cast<int32_t>(a.height),
+                                         b.y + static_cast<int32_t>(b.height));
+            return {x, y, static_cast<uint32_t>(right - x), static_cast<uint32_t>(bottom - y)};
+        }
+    } // namespace
+
+    bool window_xcb::accumulate_expose(const xcb_generic_event_t* event) {
+        auto expose_event = reinterpret_cast<const xcb_expose_event_t*>(event);
+        rect area = {expose_event->x, expose_event->y, expose_event->width, expose_event->height};
+
+        // Overlapping or adjacent rects are merged into their bounds, which keeps the region
+        // small for the common case of a window being uncovered piece by piece
+        for (std::size_t i = 0; i < m_expose_count;) {
+            if (touches(m_expose_rects[i], area)) {
+                area = bounds(m_expose_rects[i], area);
+                m_expose_rects[i] = m_expose_rects[--m_expose_count];
+                i = 0;
+            }
+            else {
+                ++i;
+            }
+        }
+
+        if (m_expose_count == max_expose_rects) {
+            area = bounds(m_expose_rects[--m_expose_count], area);
+        }
+        m_expose_rects[m_expose_count++] = area;
+
+        return expose_event->count == 0;
+    }
+
+    xcb_atom_t window_xcb::selection_atom(const clipboard_selection selection) const {
+        if (selection == clipboard_selection::e_primary) {
+            return XCB_ATOM_PRIMARY;
+        }
+        return m_clipboard_atom;
+    }
+
+    int window_xcb::selection_index(const xcb_atom_t selection) const {
+        if (selection == m_clipboard_atom) {
+            return static_cast<int>(clipboard_selection::e_clipboard);
+        }
+        if (selection == XCB_ATOM_PRIMARY) {
+            return static_cast<int>(clipboard_selection::e_primary);
+        }
+        return -1;
+    }
+
+    bool window_xcb::is_text_target(const xcb_atom_t target) const {
+        return target == m_utf8_atom || target == XCB_ATOM_STRING || target == m_text_atom ||
+               target == m_mime_text_atom;
+    }
+
+    std::size_t window_xcb::selection_chunk_size() {
+        if (m_selection_chunk_size == 0) {
+            // The request header and property fields take 24 bytes of the maximum length
+            const std::size_t max_request = xcb_get_maximum_request_length(m_connection) * 4u;
+            m_selection_chunk_size = std::min<std::size_t>(max_request - 64, 256 * 1024);
+        }
+        return m_selection_chunk_size;
+    }
+
+    void window_xcb::request_selection_slice(const int reader) {
+        auto& r = m_selection_readers[reader];
+        r.cookie = xcb_get_property(m_connection, 0, m_window, r.property,
+                                    XCB_GET_PROPERTY_TYPE_ANY, r.offset,
+                                    static_cast<uint32_t>(selection_chunk_size() / 4));
+        r.cookie_pending = true;
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::handle_selection_notify(const xcb_generic_event_t* event) {
+        auto notify_event = reinterpret_cast<const xcb_selection_notify_event_t*>(event);
+        if (notify_event->requestor != m_window) {
+            return;
+        }
+
+        const auto purpose = notify_event->selection == m_xdnd_atoms[e_xdnd_selection]
+                                 ? selection_purpose::e_drop
+                                 : selection_purpose::e_clipboard;
+        auto& reader = m_selection_readers[static_cast<int>(purpose)];
+        if (reader.state != selection_read_state::e_converting) {
+            return;
+        }
+
+        // The owner refused the conversion or there is no owner
+        if (notify_event->property == XCB_NONE) {
+            reader.failed = true;
+            return;
+        }
+
+        reader.state = selection_read_state::e_reading;
+        reader.offset = 0;
+        request_selection_slice(static_cast<int>(purpose));
+    }
+
+    void window_xcb::handle_selection_request(const xcb_generic_event_t* event) {
+        auto request_event = reinterpret_cast<const xcb_selection_request_event_t*>(event);
+
+        xcb_selection_notify_event_t notify = {};
+        notify.response_type = XCB_SELECTION_NOTIFY;
+        notify.time = request_event->time;
+        notify.requestor = request_event->requestor;
+        notify.selection = request_event->selection;
+        notify.target = request_event->target;
+        notify.property = XCB_NONE;
+
+        // Obsolete clients leave the property empty and expect the target to be used instead
+        const xcb_atom_t property =
+            request_event->property != XCB_NONE ? request_event->property : request_event->target;
+
+        const int index = selection_index(request_event->selection);
+        if (index >= 0 && m_owned_selections[index]) {
+            if (request_event->target == m_targets_atom) {
+                const xcb_atom_t targets[] = {m_targets_atom, m_utf8_atom, XCB_ATOM_STRING,
+                                              m_text_atom, m_mime_text_atom};
+                xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, request_event->requestor,
+                                    property, XCB_ATOM_ATOM, 32, std::size(targets), targets);
+                notify.property = property;
+            }
+            else if (is_text_target(request_event->target)) {
+                xcb_atom_t type = m_utf8_atom;
+                if (request_event->target == XCB_ATOM_STRING) {
+                    type = XCB_ATOM_STRING;
+                }
+                if (send_selection_data(request_event->requestor, property, type,
+                                        m_owned_selections[index])) {
+                    notify.property = property;
+                }
+            }
+        }
+
+        xcb_send_event(m_connection, 0, request_event->requestor, XCB_EVENT_MASK_NO_EVENT,
+                       reinterpret_cast<const char*>(&notify));
+        xcb_flush(m_connection);
+    }
+
+    bool window_xcb::send_selection_data(const xcb_window_t requestor, const xcb_atom_t property,
+                                         const xcb_atom_t type,
+                                         const std::shared_ptr<const std::string>& data) {
+        if (data->size() <= selection_chunk_size()) {
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, requestor, property, type, 8,
+                                data->size(), data->data());
+            return true;
+        }
+
+        // Too large for a single request, the requestor pulls the text in chunks by deleting
+        // the property after reading each one
+        auto it = std::find_if(m_selection_transfers.begin(), m_selection_transfers.end(),
+                               [&](const selection_transfer& transfer) {
+                                   return transfer.requestor == requestor &&
+                                          transfer.property == property;
+                               });
+        const auto size = static_cast<uint32_t>(std::min<std::size_t>(data->size(), UINT32_MAX));
+
+        // A new request on the same property restarts the transfer, the mask stays selected
+        if (it != m_selection_transfers.end()) {
+            it->type = type;
+            it->data = data;
+            it->offset = 0;
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, requestor, property,
+                                m_incr_atom, 32, 1, &size);
+            return true;
+        }
+
+        selection_transfer transfer = {requestor, property, type, data, 0, true, false, 0, {}};
+
+        // Property and structure changes are selected on top of whatever this client already
+        // selected on the requestor. The attributes are requested first so the reply still
+        // reports the old mask. A transfer to the same requestor already did that.
+        const bool same = std::any_of(
+            m_selection_transfers.begin(), m_selection_transfers.end(),
+            [&](const selection_transfer& other) { return other.requestor == requestor; });
+        if (same) {
+            transfer.owns_mask = false;
+        }
+        else if (requestor != m_window) {
+            transfer.mask_cookie = xcb_get_window_attributes(m_connection, requestor);
+            transfer.mask_pending = true;
+            const uint32_t mask =
+                XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+            xcb_change_window_attributes(m_connection, requestor, XCB_CW_EVENT_MASK, &mask);
+        }
+
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, requestor, property, m_incr_atom,
+                            32, 1, &size);
+
+        m_selection_transfers.push_back(std::move(transfer));
+        return true;
+    }
+
+    void window_xcb::end_selection_transfer(const std::size_t index, const bool requestor_alive) {
+        selection_transfer ended = std::move(m_selection_transfers[index]);
+        m_selection_transfers.erase(m_selection_transfers.begin() + index);
+        if (!ended.owns_mask) {
+            return;
+        }
+
+        // Another transfer to the same requestor takes over restoring the mask
+        auto other = std::find_if(m_selection_transfers.begin(), m_selection_transfers.end(),
+                                  [&](const selection_transfer& transfer) {
+                                      return transfer.requestor == ended.requestor;
+                                  });
+        if (other != m_selection_transfers.end()) {
+            other->owns_mask = true;
+            other->mask_pending = ended.mask_pending;
+            other->requestor_mask = ended.requestor_mask;
+            other->mask_cookie = ended.mask_cookie;
+        }
+        else if (requestor_alive) {
+            restore_requestor_mask(ended);
+        }
+        else if (ended.mask_pending) {
+            xcb_discard_reply(m_connection, ended.mask_cookie.sequence);
+        }
+    }
+
+    void window_xcb::restore_requestor_mask(selection_transfer& transfer) {
+        if (transfer.mask_pending) {
+            transfer.mask_pending = false;
+            void* reply = nullptr;
+            xcb_generic_error_t* error = nullptr;
+            if (xcb_poll_for_reply(m_connection, transfer.mask_cookie.sequence, &reply, &error) ==
+                0) {
+                xcb_discard_reply(m_connection, transfer.mask_cookie.sequence);
+                return;
+            }
+            free(error);
+            if (reply == nullptr) {
+                return;
+            }
+            transfer.requestor_mask =
+                static_cast<xcb_get_window_attributes_reply_t*>(reply)->your_event_mask;
+            free(reply);
+        }
+        else if (transfer.requestor == m_window) {
+            return;
+        }
+        xcb_change_window_attributes(m_connection, transfer.requestor, XCB_CW_EVENT_MASK,
+                                     &transfer.requestor_mask);
+    }
+
+    void window_xcb::handle_selection_requestor_gone(const xcb_generic_event_t* event) {
+        xcb_window_t requestor = XCB_NONE;
+        if (event->response_type == 0) {
+            auto error = reinterpret_cast<const xcb_generic_error_t*>(event);
+            if (error->error_code != XCB_WINDOW) {
+                return;
+            }
+            requestor = error->resource_id;
+        }
+        else {
+            requestor = reinterpret_cast<const xcb_destroy_notify_event_t*>(event)->window;
+        }
+
+        for (std::size_t i = m_selection_transfers.size(); i-- > 0;) {
+            if (m_selection_transfers[i].requestor == requestor) {
+                end_selection_transfer(i, false);
+            }
+        }
+    }
+
+    void window_xcb::handle_selection_clear(const xcb_generic_event_t* event) {
+        auto clear_event = reinterpret_cast<const xcb_selection_clear_event_t*>(event);
+        const int index = selection_index(clear_event->selection);
+        if (index >= 0 && clear_event->owner == m_window) {
+            m_owned_selections[index].reset();
+        }
+    }
+
+    void window_xcb::handle_selection_property(const xcb_generic_event_t* event) {
+        auto property_event = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+
+        // Incoming INCR chunk, each new value is read and deleted to request the next one
+        if (property_event->window == m_window) {
+            if (property_event->state != XCB_PROPERTY_NEW_VALUE) {
+                return;
+            }
+            for (int i = 0; i < 2; ++i) {
+                auto& reader = m_selection_readers[i];
+                if (reader.property == property_event->atom &&
+                    reader.state == selection_read_state::e_incr && !reader.cookie_pending) {
+                    reader.offset = 0;
+                    request_selection_slice(i);
+                }
+            }
+            return;
+        }
+
+        // Outgoing INCR transfer, the requestor deleted the last chunk
+        if (property_event->state != XCB_PROPERTY_DELETE) {
+            return;
+        }
+
+        auto it = std::find_if(m_selection_transfers.begin(), m_selection_transfers.end(),
+                               [&](const selection_transfer& transfer) {
+                                   return transfer.requestor == property_event->window &&
+                                          transfer.property == property_event->atom;
+                               });
+        if (it == m_selection_transfers.end()) {
+            return;
+        }
+
+        const auto length = std::min(selection_chunk_size(), it->data->size() - it->offset);
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, it->requestor, it->property,
+                            it->type, 8, length, it->data->data() + it->offset);
+        it->offset += length;
+
+        // The zero length chunk written above ends the transfer
+        if (length == 0) {
+            end_selection_transfer(it - m_selection_transfers.begin(), true);
+        }
+        xcb_flush(m_connection);
+    }
+
+    bool window_xcb::poll_selection(selection_chunk& chunk) {
+        free(chunk.reply);
+        chunk = {};
+        m_local_chunk.reset();
+
+        for (int i = 0; i < 2; ++i) {
+            auto& reader = m_selection_readers[i];
+            chunk.purpose = static_cast<selection_purpose>(i);
+
+            if (reader.local) {
+                m_local_chunk = std::move(reader.local);
+                reader.state = selection_read_state::e_idle;
+                chunk.data = *m_local_chunk;
+                chunk.finished = true;
+                return true;
+            }
+
+            if (reader.failed) {
+                reader.failed = false;
+                reader.state = selection_read_state::e_idle;
+                chunk.finished = true;
+                return true;
+            }
+
+            if (!reader.cookie_pending) {
+                continue;
+            }
+
+            void* reply = nullptr;
+            xcb_generic_error_t* error = nullptr;
+            if (xcb_poll_for_reply(m_connection, reader.cookie.sequence, &reply, &error) == 0) {
+                continue;
+            }
+            reader.cookie_pending = false;
+
+            if (reply == nullptr) {
+                free(error);
+                reader.state = selection_read_state::e_idle;
+                chunk.finished = true;
+                return true;
+            }
+
+            auto* property_reply = static_cast<xcb_get_property_reply_t*>(reply);
+
+            // Deleting the property asks an INCR owner for the next chunk
+            if (property_reply->type == m_incr_atom) {
+                free(property_reply);
+                xcb_delete_property(m_connection, m_window, reader.property);
+                xcb_flush(m_connection);
+                reader.state = selection_read_state::e_incr;
+                continue;
+            }
+
+            const auto length =
+                static_cast<std::size_t>(xcb_get_property_value_length(property_reply));
+            const bool first_slice = reader.offset == 0;
+            if (property_reply->bytes_after > 0) {
+                reader.offset += static_cast<uint32_t>(length / 4);
+                request_selection_slice(i);
+            }
+            else {
+                xcb_delete_property(m_connection, m_window, reader.property);
+                xcb_flush(m_connection);
+
+                // An empty chunk ends an INCR transfer
+                chunk.finished =
+                    reader.state == selection_read_state::e_reading || (first_slice && length == 0);
+                if (chunk.finished) {
+                    reader.state = selection_read_state::e_idle;
+                }
+            }
+
+            if (length == 0 && !chunk.finished) {
+                free(property_reply);
+                continue;
+            }
+
+            chunk.data = {static_cast<const char*>(xcb_get_property_value(property_reply)),
+                          length};
+            chunk.reply = property_reply;
+            return true;
+        }
+        return false;
+    }
+
+    void window_xcb::store_clipboard_chunk(const std::string_view data, const bool finished) {
+        m_clipboard_pending.append(data);
+        if (finished) {
+            m_clipboard_text.swap(m_clipboard_pending);
+            m_clipboard_pending.clear();
+        }
+    }
+
+    void window_xcb::set_drop_position_throttle(const std::chrono::milliseconds interval) {
+        m_drop_position_throttle = interval;
+    }
+
+    window_xcb::drop_message window_xcb::handle_drop_message(const xcb_generic_event_t* event) {
+        auto message = reinterpret_cast<const xcb_client_message_event_t*>(event);
+        const auto type = message->type;
+        const auto* data = message->data.data32;
+
+        if (type == m_xdnd_atoms[e_xdnd_enter]) {
+            m_drop_source = data[0];
+            m_drop_version = data[1] >> 24;
+            if (m_drop_types_pending) {
+                xcb_discard_reply(m_connection, m_drop_types_cookie.sequence);
+                m_drop_types_pending = false;
+            }
+            m_drop_accepted = drop_offers_uri_list(message);
+            m_drop_position_pending = false;
+            return drop_message::e_enter;
+        }
+
+        if (m_drop_source == XCB_NONE || data[0] != m_drop_source) {
+            return drop_message::e_none;
+        }
+
+        poll_drop_types();
+
+        if (type == m_xdnd_atoms[e_xdnd_position]) {
+            // Every position needs a status reply, only the notification is rate limited
+            m_drop_x = static_cast<int16_t>(data[2] >> 16) - m_root_x;
+            m_drop_y = static_cast<int16_t>(data[2] & 0xffff) - m_root_y;
+            m_drop_position_pending = true;
+            send_drop_status(m_drop_accepted);
+            return drop_message::e_position;
+        }
+
+        if (type == m_xdnd_atoms[e_xdnd_leave]) {
+            m_drop_source = XCB_NONE;
+            m_drop_position_pending = false;
+            return drop_message::e_leave;
+        }
+
+        if (type == m_xdnd_atoms[e_xdnd_drop]) {
+            auto& reader = m_selection_readers[static_cast<int>(selection_purpose::e_drop)];
+            if (!m_drop_accepted || reader.state != selection_read_state::e_idle) {
+                m_drop_position_pending = false;
+                finish_drop(false);
+                return drop_message::e_leave;
+            }
+
+            const xcb_timestamp_t time = m_drop_version >= 1 ? data[2] : XCB_CURRENT_TIME;
+            xcb_convert_selection(m_connection, m_window, m_xdnd_atoms[e_xdnd_selection],
+                                  m_xdnd_atoms[e_xdnd_uri_list], reader.property, time);
+            xcb_flush(m_connection);
+            reader.state = selection_read_state::e_converting;
+
+            // The final position goes out right away instead of waiting for the throttle
+            m_last_drop_position = {};
+            return drop_message::e_drop;
+        }
+
+        return drop_message::e_none;
+    }
+
+    bool window_xcb::drop_offers_uri_list(const xcb_client_message_event_t* enter_event) {
+        const auto* data = enter_event->data.data32;
+        const auto uri_list = m_xdnd_atoms[e_xdnd_uri_list];
+
+        // Sources offering more than three types list them in XdndTypeList
+        if ((data[1] & 1) == 0) {
+            return data[2] == uri_list || data[3] == uri_list || data[4] == uri_list;
+        }
+
+        m_drop_types_cookie = xcb_get_property(m_connection, 0, data[0],
+                                               m_xdnd_atoms[e_xdnd_type_list], XCB_ATOM_ATOM, 0,
+                                               1024);
+        m_drop_types_pending = true;
+        xcb_flush(m_connection);
+        return false;
+    }
+
+    void window_xcb::poll_drop_types() {
+        if (!m_drop_types_pending) {
+            return;
+        }
+
+        void* reply = nullptr;
+        xcb_generic_error_t* error = nullptr;
+        if (xcb_poll_for_reply(m_connection, m_drop_types_cookie.sequence, &reply, &error) == 0) {
+            return;
+        }
+        m_drop_types_pending = false;
+        free(error);
+        if (reply == nullptr) {
+            return;
+        }
+
+        auto* property_reply = static_cast<xcb_get_property_reply_t*>(reply);
+        auto* atoms = static_cast<const xcb_atom_t*>(xcb_get_property_value(property_reply));
+        const auto count = xcb_get_property_value_length(property_reply) / sizeof(xcb_atom_t);
+        m_drop_accepted = std::find(atoms, atoms + count, m_xdnd_atoms[e_xdnd_uri_list]) !=
+                          atoms + count;
+        free(reply);
+    }
+
+    void window_xcb::send_drop_status(const bool accept) {
+        xcb_client_message_event_t message = {};
+        message.response_type = XCB_CLIENT_MESSAGE;
+        message.format = 32;
+        message.window = m_drop_source;
+        message.type = m_xdnd_atoms[e_xdnd_status];
+        message.data.data32[0] = m_window;
+        // Accept and keep sending positions, the empty rectangle covers no area
+        message.data.data32[1] = accept ? 0b11 : 0;
+        message.data.data32[4] = accept ? m_xdnd_atoms[e_xdnd_action_copy] : XCB_NONE;
+
+        xcb_send_event(m_connection, 0, m_drop_source, XCB_EVENT_MASK_NO_EVENT,
+                       reinterpret_cast<const char*>(&message));
+        xcb_flush(m_connection);
+    }
+
+    void window_xcb::finish_drop(const bool success) {
+        if (m_drop_source == XCB_NONE) {
+            return;
+        }
+
+        xcb_client_message_event_t message = {};
+        message.response_type = XCB_CLIENT_MESSAGE;
+        message.format = 32;
+        message.window = m_drop_source;
+        message.type = m_xdnd_atoms[e_xdnd_finished];
+        message.data.data32[0] = m_window;
+        message.data.data32[1] = success ? 1 : 0;
+        message.data.data32[2] = success ? m_xdnd_atoms[e_xdnd_action_copy] : XCB_NONE;
+
+        xcb_send_event(m_connection, 0, m_drop_source, XCB_EVENT_MASK_NO_EVENT,
+                       reinterpret_cast<const char*>(&message));
+        xcb_flush(m_connection);
+
+        m_drop_source = XCB_NONE;
+        m_drop_accepted = false;
+    }
+
+    bool window_xcb::take_drop_position(int32_t& x, int32_t& y) {
+        if (!m_drop_position_pending) {
+            return false;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - m_last_drop_position < m_drop_position_throttle) {
+            return false;
+        }
+
+        m_last_drop_position = now;
+        m_drop_position_pending = false;
+        x = m_drop_x;
+        y = m_drop_y;
+        return true;
+    }
+
+    bool window_xcb::handle_visibility_event(const xcb_generic_event_t* event) {
+        switch (event->response_type & ~0x80) {
+            case XCB_MAP_NOTIFY: m_mapped = true; break;
+            case XCB_UNMAP_NOTIFY: m_mapped = false; break;
+            case XCB_VISIBILITY_NOTIFY: {
+                // Only sent while the window is viewable
+                auto visibility_event = reinterpret_cast<const xcb_visibility_notify_event_t*>(event);
+                m_mapped = true;
+                m_obscured = visibility_event->state == XCB_VISIBILITY_FULLY_OBSCURED;
+                break;
+            }
+            case XCB_PROPERTY_NOTIFY: {
+                // Compositing window managers keep minimized windows mapped and unobscured
+                auto property_event = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+                if (property_event->window != m_window || property_event->atom != m_wm_state_atom) {
+                    return false;
+                }
+                m_hidden = query_hidden_state();
+                break;
+            }
+            default: return false;
+        }
+
+        const bool visible = m_mapped && !m_obscured && !m_hidden;
+        if (visible == is_visible()) {
+            return false;
+        }
+
+        visible ? set_visible_flag_true() : set_visible_flag_false();
+        return true;
+    }
+
+    bool window_xcb::query_hidden_state() {
+        auto cookie =
+            xcb_get_property(m_connection, 0, m_window, m_wm_state_atom, XCB_ATOM_ATOM, 0, 32);
+        auto* reply = xcb_get_property_reply(m_connection, cookie, nullptr);
+        if (reply == nullptr) {
+            return false;
+        }
+
+        auto* atoms = reinterpret_cast<const xcb_atom_t*>(xcb_get_property_value(reply));
+        const auto count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+        const bool hidden = std::find(atoms, atoms + count, m_wm_state_hidden_atom) != atoms + count;
+        free(reply);
+        return hidden;
+    }
+
+    const char* window_xcb::get_event_name(const xcb_generic_event_t* event) {
+        // Indexed by response type, XCB_KEY_PRESS through XCB_GE_GENERIC
+        static constexpr const char* names[] = {
+            "Error",           "Reply",           "KeyPress",         "KeyRelease",
+            "ButtonPress",     "ButtonRelease",   "MotionNotify",     "EnterNotify",
+            "LeaveNotify",     "FocusIn",         "FocusOut",         "KeymapNotify",
+            "Expose",          "GraphicsExpose",  "NoExpose",         "VisibilityNotify",
+            "CreateNotify",    "DestroyNotify",   "UnmapNotify",      "MapNotify",
+            "MapRequest",      "ReparentNotify",  "ConfigureNotify",  "ConfigureRequest",
+            "GravityNotify",   "ResizeRequest",   "CirculateNotify",  "CirculateRequest",
+            "PropertyNotify",  "SelectionClear",  "SelectionRequest", "SelectionNotify",
+            "ColormapNotify",  "ClientMessage",   "MappingNotify",    "GenericEvent"};
+
+        const auto type = static_cast<std::size_t>(event->response_type & ~0x80);
+        return type < std::size(names) ? names[type] : "ExtensionEvent";
+    }
+
+    std::size_t window_xcb::get_backlog_size() {
+        // Events xcb already read off the socket are not counted by xcb itself
+        while (auto* event = xcb_poll_for_queued_event(m_connection)) {
+            m_backlog.push_back(event);
+        }
+        return m_backlog.size();
+    }
+
+    void window_xcb::inject_event(const xcb_generic_event_t& event) {
+        // xcb_generic_event_t has full_sequence past the 32 bytes of the event, left zero
+        auto* copy = static_cast<xcb_generic_event_t*>(calloc(1, sizeof(xcb_generic_event_t)));
+        std::memcpy(copy, &event, 32);
+        m_backlog.push_back(copy);
+    }
+
+    void window_xcb::latch_input() {
+        auto take_queued = [this]() {
+            while (auto* event = xcb_poll_for_queued_event(m_connection)) {
+                m_backlog.push_back(event);
+            }
+        };
+
+        // With the xcb queue empty a poll for an event reads the socket once
+        take_queued();
+        if (auto* event = xcb_poll_for_event(m_connection); event != nullptr) {
+            m_backlog.push_back(event);
+            take_queued();
+        }
+
+        for (const auto* event : m_backlog) {
+            update_input_state(event, false);
+        }
+    }
+
+    bool window_xcb::is_key_down(const key_code key) const {
+        const auto index = static_cast<uint8_t>(key);
+        return (m_input.keys[index / 64] >> (index % 64)) & 1;
+    }
+
+    bool window_xcb::is_mouse_button_down(const mouse_code button) const {
+        return (m_input.buttons >> static_cast<uint8_t>(button)) & 1;
+    }
+
+    namespace {
+        // Server timestamps wrap after 49 days, compare them by difference
+        inline int32_t time_diff(const uint32_t a, const uint32_t b) {
+            return static_cast<int32_t>(a - b);
+        }
+
+        constexpr int32_t pointer_idle_ms = 100;
+        constexpr int32_t max_prediction_ms = 50;
+    } // namespace
+
+    void window_xcb::push_pointer_sample(const int32_t x, const int32_t y, const uint32_t time) {
+        if (m_pointer_count > 0) {
+            const auto& last =
+                m_pointer_history[(m_pointer_head + pointer_history_size - 1) % pointer_history_size];
+            // Events latched by latch_input are applied again when dispatched
+            const auto age = time_diff(time, last.time);
+            if (age < 0 || (age == 0 && last.x == x && last.y == y)) {
+                return;
+            }
+        }
+
+        m_pointer_history[m_pointer_head] = {x, y, time};
+        m_pointer_head = (m_pointer_head + 1) % pointer_history_size;
+        m_pointer_count = std::min(m_pointer_count + 1, pointer_history_size);
+
+        // The minimum is taken per window of a few seconds so drift and wrap around are followed
+        using namespace std::chrono;
+        const auto now = steady_clock::now();
+        const int64_t offset =
+            duration_cast<milliseconds>(now.time_since_epoch()).count() - int64_t(time);
+        m_offset_window_min = std::min(m_offset_window_min, offset);
+        m_server_clock_offset = std::min(m_server_clock_offset, offset);
+        if (now - m_offset_window_start >= seconds(5)) {
+            m_server_clock_offset = m_offset_window_min;
+            m_offset_window_min = INT64_MAX;
+            m_offset_window_start = now;
+        }
+    }
+
+    std::size_t window_xcb::get_pointer_history(pointer_sample* samples,
+                                                const std::size_t capacity) const {
+        const auto count = std::min(capacity, m_pointer_count);
+        const auto first = m_pointer_head + pointer_history_size - count;
+        for (std::size_t i = 0; i < count; ++i) {
+            samples[i] = m_pointer_history[(first + i) % pointer_history_size];
+        }
+        return count;
+    }
+
+    uint32_t window_xcb::to_server_time(const std::chrono::steady_clock::time_point when) const {
+        if (m_server_clock_offset == INT64_MAX) {
+            return m_event_time;
+        }
+
+        using namespace std::chrono;
+        const int64_t ms = duration_cast<milliseconds>(when.time_since_epoch()).count();
+        return static_cast<uint32_t>(ms - m_server_clock_offset);
+    }
+
+    pointer_sample window_xcb::predict_pointer(const std::chrono::steady_clock::time_point when,
+                                               const pointer_predictor predictor) const {
+        const auto target = to_server_time(when);
+        if (m_pointer_count == 0) {
+            return {m_input.mouse_x, m_input.mouse_y, target};
+        }
+
+        auto at = [this](const std::size_t i) -> const pointer_sample& {
+            return m_pointer_history[(m_pointer_head + pointer_history_size - m_pointer_count + i) %
+                                     pointer_history_size];
+        };
+
+        const auto& last = at(m_pointer_count - 1);
+        pointer_sample result = {last.x, last.y, target};
+
+        // A pointer that stopped moving is not extrapolated
+        const auto ahead = time_diff(target, last.time);
+        if (ahead <= 0 || ahead > pointer_idle_ms || m_pointer_count < 2) {
+            return result;
+        }
+
+        double velocity_x = 0.0;
+        double velocity_y = 0.0;
+        if (predictor == pointer_predictor::e_linear) {
+            // Velocity between the last sample and the closest one with an earlier timestamp
+            for (std::size_t i = m_pointer_count - 1; i-- > 0;) {
+                const auto dt = time_diff(last.time, at(i).time);
+                if (dt > 0) {
+                    velocity_x = double(last.x - at(i).x) / dt;
+                    velocity_y = double(last.y - at(i).y) / dt;
+                    break;
+                }
+            }
+        }
+        else {
+            // Exponentially smoothed velocity over the recent samples, robust to the jitter of
+            // millisecond timestamps
+            bool initialized = false;
+            for (std::size_t i = 1; i < m_pointer_count; ++i) {
+                const auto& prev = at(i - 1);
+                const auto& curr = at(i);
+                const auto dt = time_diff(curr.time, prev.time);
+                if (dt <= 0 || time_diff(last.time, prev.time) > pointer_idle_ms) {
+                    continue;
+                }
+
+                const double vx = double(curr.x - prev.x) / dt;
+                const double vy = double(curr.y - prev.y) / dt;
+                if (!initialized) {
+                    velocity_x = vx;
+                    velocity_y = vy;
+                    initialized = true;
+                }
+                else {
+                    velocity_x += 0.5 * (vx - velocity_x);
+                    velocity_y += 0.5 * (vy - velocity_y);
+                }
+            }
+        }
+
+        const double horizon = std::min(ahead, max_prediction_ms);
+        result.x = last.x + static_cast<int32_t>(std::lround(velocity_x * horizon));
+        result.y = last.y + static_cast<int32_t>(std::lround(velocity_y * horizon));
+        return result;
+    }
+
+    void window_xcb::update_motion_history() {
+        if (m_motion_cookie_pending) {
+            void* reply = nullptr;
+            xcb_generic_error_t* error = nullptr;
+            if (xcb_poll_for_reply(m_connection, m_motion_cookie.sequence, &reply, &error) != 0) {
+                m_motion_cookie_pending = false;
+                if (reply != nullptr) {
+                    merge_motion_events(static_cast<xcb_get_motion_events_reply_t*>(reply));
+                }
+                free(reply);
+                free(error);
+            }
+        }
+
+        if (!m_motion_backfill || m_motion_cookie_pending || m_pointer_count == 0) {
+            return;
+        }
+
+        const auto newest =
+            m_pointer_history[(m_pointer_head + pointer_history_size - 1) % pointer_history_size];
+        if (m_backfill_start == 0) {
+            m_backfill_start = m_pointer_history[(m_pointer_head + pointer_history_size -
+                                                  m_pointer_count) %
+                                                 pointer_history_size]
+                                   .time;
+        }
+
+        if (newest.time != m_backfill_start) {
+            m_motion_cookie =
+                xcb_get_motion_events(m_connection, m_window, m_backfill_start, newest.time);
+            m_motion_cookie_pending = true;
+            m_backfill_start = newest.time;
+            xcb_flush(m_connection);
+        }
+    }
+
+    void window_xcb::merge_motion_events(const xcb_get_motion_events_reply_t* reply) {
+        const auto* coords = xcb_get_motion_events_events(reply);
+        const auto coord_count =
+            static_cast<std::size_t>(xcb_get_motion_events_events_length(reply));
+        if (coord_count == 0) {
+            return;
+        }
+
+        pointer_sample history[pointer_history_size];
+        const auto history_count = get_pointer_history(history, pointer_history_size);
+
+        // Both sequences are sorted by time, samples already in the history win on equal times
+        m_pointer_merge.clear();
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < history_count || j < coord_count) {
+            if (j == coord_count ||
+                (i < history_count && time_diff(history[i].time, coords[j].time) <= 0)) {
+                if (j < coord_count && history[i].time == coords[j].time) {
+                    ++j;
+                }
+                m_pointer_merge.push_back(history[i++]);
+            }
+            else {
+                m_pointer_merge.push_back({coords[j].x, coords[j].y, coords[j].time});
+                ++j;
+            }
+        }
+
+        const auto count = std::min(m_pointer_merge.size(), pointer_history_size);
+        std::copy(m_pointer_merge.end() - count, m_pointer_merge.end(), m_pointer_history);
+        m_pointer_count = count;
+        m_pointer_head = count % pointer_history_size;
+    }
+
+    void window_xcb::update_input_state(const xcb_generic_event_t* event,
+                                        const bool take_samples) {
+        switch (event->response_type & ~0x80) {
+            case XCB_KEY_PRESS:
+            case XCB_KEY_RELEASE: {
+                auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(event);
+                const auto index = static_cast<uint8_t>(keycode_to_enum(key_event->detail));
+                const uint64_t bit = uint64_t(1) << (index % 64);
+                (event->response_type & ~0x80) == XCB_KEY_PRESS ? m_input.keys[index / 64] |= bit
+                                                                 : m_input.keys[index / 64] &= ~bit;
+                m_event_time = key_event->time;
+                break;
+            }
+            case XCB_BUTTON_PRESS:
+            case XCB_BUTTON_RELEASE: {
+                auto button_event = reinterpret_cast<const xcb_button_press_event_t*>(event);
+                // Scroll wheel buttons have no held state
+                if (button_event->detail < 4 || button_event->detail > 7) {
+                    const uint32_t bit = 1u << static_cast<uint8_t>(
+                                             mousecode_to_enum(button_event->detail));
+                    (event->response_type & ~0x80) == XCB_BUTTON_PRESS ? m_input.buttons |= bit
+                                                                        : m_input.buttons &= ~bit;
+                }
+                m_input.mouse_x = button_event->event_x;
+                m_input.mouse_y = button_event->event_y;
+                m_event_time = button_event->time;
+                if (take_samples) {
+                    push_pointer_sample(m_input.mouse_x, m_input.mouse_y, m_event_time);
+                }
+                break;
+            }
+            // Pointer events share the layout of the motion event up to the event position
+            case XCB_MOTION_NOTIFY:
+            case XCB_ENTER_NOTIFY:
+            case XCB_LEAVE_NOTIFY: {
+                auto motion_event = reinterpret_cast<const xcb_motion_notify_event_t*>(event);
+                m_input.mouse_x = motion_event->event_x;
+                m_input.mouse_y = motion_event->event_y;
+                m_event_time = motion_event->time;
+                if (take_samples) {
+                    push_pointer_sample(m_input.mouse_x, m_input.mouse_y, m_event_time);
+                }
+                break;
+            }
+            case XCB_PROPERTY_NOTIFY: {
+                m_event_time = reinterpret_cast<const xcb_property_notify_event_t*>(event)->time;
+                break;
+            }
+            default: break;
+        }
+    }
+
+    bool window_xcb::is_replayable(const xcb_generic_event_t* event) {
+        switch (event->response_type & ~0x80) {
+            case XCB_KEY_PRESS:
+            case XCB_KEY_RELEASE:
+            case XCB_BUTTON_PRESS:
+            case XCB_BUTTON_RELEASE:
+            case XCB_MOTION_NOTIFY:
+            case XCB_ENTER_NOTIFY:
+            case XCB_LEAVE_NOTIFY:
+            case XCB_FOCUS_IN:
+            case XCB_FOCUS_OUT:
+            case XCB_EXPOSE:
+            case XCB_CONFIGURE_NOTIFY:
+            case XCB_MAP_NOTIFY:
+            case XCB_UNMAP_NOTIFY:
+            case XCB_VISIBILITY_NOTIFY: return true;
+            default: return false;
+        }
+    }
+
+    bool window_xcb::is_close_event(const xcb_generic_event_t* event) const {
+        auto client_event = reinterpret_cast<const xcb_client_message_event_t*>(event);
+        return client_event->data.data32[0] == m_delete_window_atom->atom;
+    }
+
+    bool window_xcb::is_key_down_event(const xcb_generic_event_t* event,
+                                       const xcb_generic_event_t* prev) const {
+        auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(event);
+        auto prev_event = reinterpret_cast<const xcb_key_release_event_t*>(prev);
+        return !(prev && ((prev->response_type & ~0x80) == XCB_KEY_RELEASE) &&
+                (prev_event->detail == key_event->detail) && (prev_event->time == key_event->time));
+    }
+
+    bool window_xcb::is_key_up_event(const xcb_generic_event_t* event,
+                                     const xcb_generic_event_t* next) const {
+        auto key_event = reinterpret_cast<const xcb_key_press_event_t*>(event);
+        auto next_event = reinterpret_cast<const xcb_key_release_event_t*>(next);
+        return !(next && ((next->response_type & ~0x80) == XCB_KEY_PRESS) &&
+                  (next_event->detail == key_event->detail) &&
+                  (next_event->time == key_event->time));
+    }
+
+    inline xcb_intern_atom_reply_t* window_xcb::intern_atom_helper(bool only_if_exists,
+                                                                   const char* str) {
+        xcb_intern_atom_cookie_t cookie =
+            xcb_intern_atom(m_connection, only_if_exists, std::strlen(str), str);
+        return xcb_intern_atom_reply(m_connection, cookie, nullptr);
+    }
+
+    void window_xcb::intern_atoms(const char* const* names, xcb_atom_t* atoms,
+                                  const std::size_t count) {
+        std::vector<xcb_intern_atom_cookie_t> cookies(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            cookies[i] = xcb_intern_atom(m_connection, 0, std::strlen(names[i]), names[i]);
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            auto* reply = xcb_intern_atom_reply(m_connection, cookies[i], nullptr);
+            atoms[i] = reply != nullptr ? reply->atom : XCB_NONE;
+            free(reply);
+        }
+    }
+
+    xcb_atom_t window_xcb::intern_atom(bool only_if_exists, const char* str) {
+        auto* reply = intern_atom_helper(only_if_exists, str);
+        if (reply == nullptr) {
+            return XCB_NONE;
+        }
+
+        const auto atom = reply->atom;
+        free(reply);
+        return atom;
     }
 
     key_code window_xcb::keycode_to_enum(const uint8_t code) const {